@@ -24,108 +24,33 @@
 //
 // =====================================================================
 
-#include <cctype> // for isspace
+#include <cstring> // for std::memchr
 #include <sstream> // for std::stringstream
 
 #include "RMMIXJobLang.h"
 
-// Before the methods start, a few utilities (functions)
-// in an anonymous namespace (so that they are not exported)
-namespace {
-
-void cleanupLine( std::string& line ) // static by the way
-{
-    if (line.empty()) return; // unnecessary but saves time
-    
-    const char comma = ',';
-    const char space = ' ';
-    const char commentDelimiter = '%';
-    auto iter = line.begin(); // Note C++11 "auto" declaration
-
-    // remove leading white space
-    while ((iter != line.end())
-            && std::isspace(*iter)) // includes spaces, tabs, etc.
-        iter = line.erase(iter);
-    if (line.empty()) return; // unnecessary but saves time
-
-    // search for a comment character commentDelimiter == '%')
-    // and replace commas with spaces along the way
-    while ((iter != line.end())
-            && (commentDelimiter != *iter)) {
-        if (comma == *iter) *iter = space;
-        ++iter;
-    }; // end while not at end or at comment character
-    // Either iter == line.end OR RMMIXcommentDelimiter == *iter
-    if (iter != line.end())
-        line.erase(iter, line.end());
-
-    // remove trailing white space
-    while ( !line.empty() && std::isspace(line.back()) )
-        line.pop_back();
-
-
-} // end cleanupLineBuffer
-
-bool containsJobControl(const std::string &line, const std::string &pattern)
-{
-    // basic sanity check
-    if (line.empty()) return false; // unnecessary but saves time
-    if ('$' != line[0]) return false;
-    // OK, there could be the right job control line here...
-    std::stringstream sstrm(line);
-    std::string contents;
-    if (!(sstrm >> contents)) return false;
-    // else... 
-    bool result = (contents == pattern);
-    return result;
-} // end containsJobControl
-
-int decodeOpSymbol( const std::string& opSym ) {
-    int opCode = RMMIX_JDL::lookup( RMMIX_JDL::opCodes, opSym );
-    if ( RMMIX_JDL::opCodeOK( opCode ) ) 
-        return opCode;
-    else {
-        opCode = RMMIX_JDL::lookup( RMMIX_JDL::pseudoOpCodes, opSym );
-        if ( RMMIX_JDL::opCodeOK( opCode ) ) 
-            return opCode;
-        else // if not a valid pseudoOpCode
-            return -1;
-    }; // if not in opCodes table
-} // end decodeOpSymbol
-
-
-} // end anonymous namespace
-
 // Begin Methods for theJobLangCompiler class and its extensions
 
 bool JobLangCompiler::refillLineBuffer()
 {   
     // Start with a clean slate.
     lastOperationOK = true; // until something goes wrong...
-    lineBuffer.clear();
-    lineBuffer.str("");
+    lexer.clear();
     // Get a line from the file, clean it up (remove comments, etc.).
     // If the line (after cleaning) is blank, repeat (unless we hit eof)
-    std::string line;
+    bool blank = true;
     do {
         if ( inStream.eof() ) 
             return (lastOperationOK = false); // no point going on if at eof...
         // else, if not yet at eof, get a line of text (not a token!)
-        lastOperationOK = ( std::getline( inStream, line ) );
+        lastOperationOK = static_cast<bool>( std::getline( inStream, lineText ) );
         if ( lastOperationOK ) {
             lineNumber++; // count lines!
-            cleanupLine( line );
+            blank = ! lexer.scan( lineText.data(), 
+                                  lineText.data() + lineText.size() );
         };
-    } while( lastOperationOK && line.empty() ); 
-    
-    // if last operation OK, store line in lineBuffer
-    if (lastOperationOK) {
-        lineBuffer.clear( );
-        lineBuffer.str( line );
-    };
-//    std::cout << "End of refillLineBuffer, lineBuffer = <" << lineBuffer.str()
-//              << ">." << std::endl;
-    return lastOperationOK; // == true
+    } while( lastOperationOK && blank ); 
+    return lastOperationOK;
 } // end refillLineBuffer
 
 // Instruction reader
@@ -134,8 +59,7 @@ JobLangCompiler& JobLangCompiler::operator>>(RMMIXinstruction& instruction) {
     lastOperationOK = true; // until something goes wrong
     if (gotoState( codeReaderState)) 
         if ( refillLineBuffer( ) ) {
-            lastOperationOK = ! containsJobControl( lineBuffer.str(), 
-                                                    "$RUN" );
+            lastOperationOK = ! isJobControl( "$RUN" );
             if (lastOperationOK)
                 getInstruction(instruction); 
         };
@@ -148,8 +72,7 @@ JobLangCompiler& JobLangCompiler::operator>>(int& inputNumber) {
     lastOperationOK = true; // until something goes wrong...
     if (gotoState( inputReaderState)) 
         if ( refillLineBuffer( ) ) {
-            lastOperationOK =  ! containsJobControl( lineBuffer.str(), 
-                                                     "$END" );
+            lastOperationOK =  ! isJobControl( "$END" );
             if (lastOperationOK)
                 getNumber(inputNumber); 
         };
@@ -158,49 +81,167 @@ JobLangCompiler& JobLangCompiler::operator>>(int& inputNumber) {
 
 bool JobLangCompiler::getToken( std::string& token )
 {
-    lastOperationOK = ( lineBuffer >> token ); 
+    RMMIX_JDL::textView view;
+    if ( getToken( view ) )
+        token.assign( view.begin, view.end );
     return lastOperationOK;
 } // end getToken
 
 
+// The scanner - does what refillLineBuffer does, but directly in the
+// mapped file, instead of in a copy of each line
+
+bool objectCodeDecompiler::refillLineBuffer()
+{
+    if ( ! text ) return JobLangCompiler::refillLineBuffer();
+    lastOperationOK = true; // until something goes wrong...
+    lexer.clear();
+    bool blank = true;
+    do {
+        if ( atEOF ) 
+            return (lastOperationOK = false); // no point going on if at eof...
+        if ( text->end() == nextLine ) { // std::getline would fail here
+            atEOF = failed = true;
+            return (lastOperationOK = false);
+        };
+        const char* newline = static_cast< const char* >( 
+            std::memchr( nextLine, '\n', text->end() - nextLine ) );
+        const char* end = newline ? newline : text->end();
+        atEOF = ! newline; // the last line, without a '\n'
+        lineNumber++; // count lines!
+        blank = ! lexer.scan( nextLine, end );
+        nextLine = newline ? newline + 1 : end;
+    } while( blank ); 
+    return lastOperationOK; // == true
+} // end refillLineBuffer
+
 bool objectCodeDecompiler::getNumber(int &inputNumber)
 {
-    lastOperationOK = (  lineBuffer >> std::hex >> inputNumber  ); 
-//    std::cout << "end of obj get number, num = " << inputNumber
-//              << ", OK = " << lastOperationOK << std::endl;
+    lastOperationOK = lexer.nextNumber( inputNumber, 16 ); // i.e. std::hex
     return lastOperationOK;
 } // end getNumber
 
+objectCodeDecompiler::objectCodeDecompiler(const char* fileName,
+                                           readerType reader)
+: JobLangCompiler(fileName)
+{
+    // Regular files are mapped into memory - anything else (e.g. a pipe)
+    // can only be read line by line from inStream, without rewinding.
+    std::unique_ptr< RMMIX_JDL::mappedFile > mapped;
+    if ( inStream.good() ) try {
+        mapped.reset( new RMMIX_JDL::mappedFile( fileName ) );
+    } catch ( std::string error ) {
+        // keep reading from inStream
+    };
+    if ( mapped && ( sizeof( std::int32_t ) <= mapped->size )
+         && RMMIX_JDL::isBinaryObjectMagic(
+                *reinterpret_cast< const std::int32_t* >( mapped->begin() ) ) ) {
+        inStream.close(); // the image does not need the stream
+        try {
+            image.reset( new RMMIX_JDL::binaryObjectImage( fileName ) );
+        } catch ( std::string error ) {
+            std::cerr << error << std::endl;
+            inStream.setstate( std::ios::failbit ); // i.e. not good()
+        };
+    } else if ( mapped && ( scanningReader == reader ) ) {
+        text = std::move( mapped );
+        nextLine = text->begin();
+        inStream.close(); // the scanner does not need the stream
+    };
+} // end constructor
+
+// In the binary object format, the states are simply positions in the
+// image - there is nothing to skip over, and no line to parse.
+
+bool objectCodeDecompiler::gotoState(stateType newState)
+{
+    if ( ! image ) return JobLangCompiler::gotoState( newState );
+    assert((codeReaderState == newState) || (inputReaderState == newState));
+
+    // Stay in the current job only if we are about to read its code
+    // (e.g. when the loader is called right after finding $JOB)
+    lastOperationOK = true;
+    if ( ( codeReaderState == newState ) && ( 0 == position )
+         && ( codeReaderState == state ) )
+        return lastOperationOK;
+    if ( ( codeReaderState == newState ) || ( job < 0 ) ) { // next $JOB
+        lastOperationOK = ( job + 1 < image->jobs() );
+        if ( ! lastOperationOK ) return lastOperationOK;
+        ++job;
+        position = 0;
+        state = codeReaderState;
+        jobname = image->jobName( job );
+    };
+    if ( ( inputReaderState == newState ) && ( inputReaderState != state ) ) {
+        lastOperationOK = ( RMMIX_JDL::noInput != image->inputWords( job ) );
+        if ( lastOperationOK ) { // i.e. if $RUN found
+            position = 0;
+            state = inputReaderState;
+        };
+    };
+    return lastOperationOK;
+} // end gotoState
+
+objectCodeDecompiler& objectCodeDecompiler::operator>>(RMMIXinstruction& instruction)
+{
+    if ( ! image ) {
+        JobLangCompiler::operator>>( instruction );
+        return (*this);
+    };
+    lastOperationOK = ( codeReaderState == state )
+                      || gotoState( codeReaderState );
+    if ( lastOperationOK ) {
+        lastOperationOK = ( position < image->instructions( job ) );
+        if ( lastOperationOK )
+            instruction = image->instruction( job, position++ );
+    };
+    return (*this);
+}
+
+objectCodeDecompiler& objectCodeDecompiler::operator>>(int& inputNumber)
+{
+    if ( ! image ) {
+        JobLangCompiler::operator>>( inputNumber );
+        return (*this);
+    };
+    lastOperationOK = gotoState( inputReaderState );
+    if ( lastOperationOK ) {
+        lastOperationOK = ( position < image->inputWords( job ) );
+        if ( lastOperationOK )
+            inputNumber = image->input( job, position++ );
+    };
+    return (*this);
+}
+
 bool assemblyCompiler::getNumber(int &inputNumber)
 {
-    lastOperationOK = ( lineBuffer >> std::dec >> inputNumber ); 
-//    std::cout << "end of asm get number, num = " << inputNumber
-//              << ", OK = " << lastOperationOK << std::endl;
+    lastOperationOK = lexer.nextNumber( inputNumber, 10 ); // i.e. std::dec
     return lastOperationOK;
 } // end getNumber
 
 
 bool assemblyCompiler::getOpCode(int &opCode)
 {
-    std::string opSym;
+    RMMIX_JDL::textView opSym;
     lastOperationOK = getToken( opSym );
     if ( lastOperationOK ) {
-        opCode = decodeOpSymbol( opSym );
+        opCode = RMMIX_JDL::lookupOpCode( opSym.begin, opSym.size() );
         lastOperationOK = RMMIX_JDL::opCodeOK( opCode );
         if ( !lastOperationOK ) {
             // if it's not a valid op code,
             // we (apparently) found an instruction label.
-            int jumpLocation = RMMIX_JDL::lookup( jumpTable, opSym );
+            const std::string label = opSym.str();
+            int jumpLocation = RMMIX_JDL::lookup( jumpTable, label );
             if ( jumpLocation < 0 ) {
-                jumpTable[ opSym ] = instructionNumber;
+                jumpTable[ label ] = instructionNumber;
             }
             else if ( jumpLocation != instructionNumber ) {
                 std::stringstream suffix;
-                suffix << "Ambiguous Label: " << opSym
+                suffix << "Ambiguous Label: " << label
                        << " can mean instruction " << instructionNumber
                        << " or " << jumpLocation
                        << ", line: "
-                       << lineBuffer.str();
+                       << currentLine();
                 throw RMMIX_JDLexception( suffix.str() );
             };
             // if we're here, label found, and OK.
@@ -213,11 +254,11 @@ bool assemblyCompiler::getOpCode(int &opCode)
             // Now our patience is exhausted...
             if ( ! lastOperationOK ) {
                 throw RMMIX_JDLexception( 
-                        std::string( "Apparent label " )+ opSym +
+                        std::string( "Apparent label " )+ label +
                         std::string( " not followed by instruction, current line buffer = ")
-                        + lineBuffer.str() );
+                        + currentLine() );
             } else { // if lastOperationOK
-                opCode = decodeOpSymbol( opSym );
+                opCode = RMMIX_JDL::lookupOpCode( opSym.begin, opSym.size() );
                 lastOperationOK = RMMIX_JDL::opCodeOK( opCode );
             }; // end if token found after label
         }; // end if label found
@@ -225,24 +266,43 @@ bool assemblyCompiler::getOpCode(int &opCode)
     // Update instructionNumber - this would be better in getInstruction,
     // but we only want to do it for assemblyCompiler class... so... do it here.
     if (lastOperationOK) ++instructionNumber;
+    operandNumber = 0; // the operands come next
     return lastOperationOK;
 } // end getOpCode
 
+assemblyCompiler& assemblyCompiler::operator>>(RMMIXinstruction& instruction) {
+    lastOperationOK = true; // until something goes wrong
+    if ( gotoState( codeReaderState ) ) {
+        lastOperationOK = ( nextAssembled < assembled.size() );
+        if ( lastOperationOK ) {
+            const assembledLine& line = assembled[ nextAssembled++ ];
+            if ( ! line.error.empty() )
+                throw line.error;
+            instruction = line.instruction;
+        };
+    };
+    return (*this);
+}
+
 bool assemblyCompiler::getOperand(int &operand)
 {
-    std::string opSym;
-    lastOperationOK = getToken( opSym );
+    RMMIX_JDL::textView token;
+    ++operandNumber;
+    lastOperationOK = getToken( token );
     if ( lastOperationOK ) {
-        operand = RMMIX_JDL::lookup( RMMIX_JDL::trapCodes, opSym );
-        if( ! RMMIX_JDL::trapCodeOK( operand ) )
-        {
-            // Is opSym a number?
-            lastOperationOK = ( std::stringstream( opSym ) >> operand );
-            if ( !lastOperationOK ) { // not a number
-                int landingPad = RMMIX_JDL::lookup( jumpTable, opSym );
-                operand = landingPad - instructionNumber;
-                lastOperationOK = true;
-            }; // end if not a number
+        // Is the token a number?  (No trap name starts like one, so we
+        // can look at numbers first, without copying the token.)
+        const char* cursor = token.begin;
+        if ( RMMIX_JDL::parseNumber( cursor, token.end, 10, operand ) )
+            return lastOperationOK;
+        operand = RMMIX_JDL::lookupTrapCode( token.begin, token.size() );
+        if( ! RMMIX_JDL::trapCodeOK( operand ) ) { // so it is a label
+            std::string opSym = token.str();
+            int landingPad = RMMIX_JDL::lookup( jumpTable, opSym );
+            if ( landingPad < 0 ) // not yet defined (see buildJumpTable)
+                forwardReferences.push_back( forwardReference{
+                    assembled.size(), operandNumber, instructionNumber, opSym } );
+            operand = landingPad - instructionNumber;
         };
     }; // end is getToken worked
     return lastOperationOK;
@@ -260,7 +320,7 @@ bool JobLangCompiler::gotoState(stateType newState)
 
     // If we're already in the right state, there's nothing to do
     while ( newState != state ) {
-        lastOperationOK = containsJobControl( lineBuffer.str(), targetKeyword );
+        lastOperationOK = isJobControl( targetKeyword.c_str() );
         if ( ! lastOperationOK ) {
             // We found something else, not what we were looking for
             // If we can read another line, good, keep searching, 
@@ -272,13 +332,13 @@ bool JobLangCompiler::gotoState(stateType newState)
             state = newState;
             if ( codeReaderState == newState ) {
                 if ( !getToken( token ))
-                    std::cerr << "Serious logic error at file "
+                    *messages << "Serious logic error at file "
                             << __FILE__ << ":" << __LINE__
                             << std::endl;
                 if ( !getToken( token ) ) 
                     throw RMMIX_JDLexception(
                             std::string( "Could not find job name in line: " )
-                            + lineBuffer.str() );
+                            + currentLine() );
                 // else, if job name found...
                 jobname = token;
                 buildJumpTable( );
@@ -298,32 +358,37 @@ void assemblyCompiler::prepareForState( stateType newState ) {
 }; // end prepareForState();
 
 void assemblyCompiler::buildJumpTable( ) {
- 
+
+    // Assemble the whole job in one pass: labels are entered into
+    // jumpTable as they are found (see getOpCode), operands naming labels
+    // further down are patched at the end (see getOperand).  No rewinding,
+    // so the file can also be a pipe.
+    assembled.clear();
+    nextAssembled = 0;
+    forwardReferences.clear();
     if ( !good() || eof() ) return; // cannot proceed if not good or at eof
 
-    // Store state, so we can restore it later
-    int originalLineNumber = lineNumber;
-    int originalInstrNumber = instructionNumber;
-    int placeMarker = inStream.tellg(); // so we can rewind to here
-    std::string lineBufferString = lineBuffer.str( );
-    
-    RMMIXinstruction tempInstruction;
     bool moreToDo = true; // until we find we're finished
     while ( moreToDo ) {
+        assembledLine next;
         try {
-            moreToDo = ( (*this) >> tempInstruction );
+            moreToDo = bool( JobLangCompiler::operator>>( next.instruction ) );
         } catch ( std::string errorString ) {
-            // Suppress errors in this phase!!
-//            std::cout << "Suppressing exception <" << errorString 
-//                      << std::endl;
+            next.error = errorString; // thrown when the instruction is read
         }; 
+        if ( moreToDo )
+            assembled.push_back( next );
     }; // end while moreToDo
-    // restore state
-    lineNumber = originalLineNumber;
-    instructionNumber = originalInstrNumber;
-    inStream.seekg( placeMarker );
+
+    for ( const forwardReference& reference : forwardReferences ) {
+        assembledLine& line = assembled[ reference.line ];
+        int landingPad = RMMIX_JDL::lookup( jumpTable, reference.label );
+        if ( line.error.empty() && ( landingPad >= 0 )
+             && ( reference.field < line.instruction.numFields ) )
+            line.instruction.fields[ reference.field ] =
+                landingPad - reference.instructionNumber;
+    }; // end for all forward references
     lastOperationOK = true;
-    lineBuffer.str( ) = lineBufferString;
 
 }; // end buildJumpTable
 
@@ -338,7 +403,7 @@ bool JobLangCompiler::getInstruction(RMMIXinstruction& instruction)
     if ( ! lastOperationOK )  
         throw RMMIX_JDLexception( 
                       std::string( "Could not find legal operation in line: " )
-                      + lineBuffer.str()  );
+                      + currentLine()  );
     else { // if lastOperationOK 
         int numOperands = int(RMMIX_JDL::numberOfOperands( opCode ));
         int operands[3] = {0, 0, 0};
@@ -349,7 +414,7 @@ bool JobLangCompiler::getInstruction(RMMIXinstruction& instruction)
         if ( ! lastOperationOK ) 
                 throw RMMIX_JDLexception( 
                       std::string("Could not find required operands in line: " )
-                      + lineBuffer.str()  );
+                      + currentLine()  );
         else { // if all required operands present
             // check if there are TOO MANY operands
             int dummy;
@@ -357,7 +422,7 @@ bool JobLangCompiler::getInstruction(RMMIXinstruction& instruction)
             if ( ! lastOperationOK ) 
                 throw RMMIX_JDLexception(  
                         std::string( "Too many operands in line: " )
-                        +lineBuffer.str() );
+                        +currentLine() );
             else  // if exactly the right number of oprands present            
                 instruction.reset( opCode, numOperands,
                                    operands[0], operands[1], operands[2] );
@@ -29,11 +29,15 @@
 #include <cassert>      // assert()
 #include <string>       // std::string
 #include <fstream>      // std::ifstream
-#include <ostream>      // for std::cerr
+#include <iostream>     // for std::cerr
 #include <sstream>      // std::stringstream
+#include <memory>       // std::unique_ptr
+#include <vector>       // std::vector
 
 #include "RMMIXcodes.h"
 #include "RMMIXinstruction.h"
+#include "RMMIXbinaryObject.h"
+#include "RMMIXlexer.h"
 
 /*  class: JobLangCompiler
  ******************************************************* 
@@ -64,9 +68,11 @@ public:
     // (required by operator bool() )
     bool lastOperationOK = true; // C++11 initialization!
 
-    // Internal buffers - each line of input is read into  lineBuffer,
-    // where comments are removed, blank lines are skipped (etc.).
-    std::stringstream lineBuffer;
+    // Each line of input is read into lineText (unless the reader scans
+    // a mapped file in place), and split into tokens by the lexer - which
+    // skips comments, blank lines (etc.), see RMMIXlexer.h.
+    std::string           lineText;
+    RMMIX_JDL::lineLexer  lexer;
 
     // we need to keep track of the line number in order to give 
     // better error messages
@@ -75,10 +81,24 @@ public:
     // This next buffer is used to store error messages whenever
     // (input) errors are detected.
     std::stringstream errorBuffer; // implicitly initialized to blank.
+
+    // Messages that are not exceptions go here (rmmixas --parallel
+    // collects them in a buffer, to keep them in order)
+    std::ostream* messages = &std::cerr;
     
     // Utilities - 
-    // Get new line of text and call cleanupLineBuffer as long as necessary
-    bool refillLineBuffer(); 
+    // Get the next line that is not blank (after cleaning it up)
+    virtual bool refillLineBuffer(); 
+
+    // The current line (cleaned up), e.g. for error messages
+    std::string currentLine() const {
+        return lexer.text();
+    }
+
+    // Is the current line the job control line keyword (e.g. "$RUN")?
+    bool isJobControl( const char* keyword ) const {
+        return lexer.isKeyword( keyword );
+    }
     
 
 public:
@@ -95,11 +115,11 @@ public:
 
     // Methods from std::ifstream, which we can just "inherit"
 
-    bool eof() const {
+    virtual bool eof() const {
         return inStream.eof();
     }
 
-    bool good() const {
+    virtual bool good() const {
         return inStream.good();
     }
 
@@ -117,17 +137,20 @@ public:
 
     // HERE ARE THE KEY METHODS - EVERYTHING ELSE IS HERE TO ALLOW THESE!
     // Instruction reader
-    JobLangCompiler& operator>>(RMMIXinstruction& instruction);
+    virtual JobLangCompiler& operator>>(RMMIXinstruction& instruction);
     // Input reader
-    JobLangCompiler& operator>>(int& inputNumber);
+    virtual JobLangCompiler& operator>>(int& inputNumber);
 
     // Of course, sometimes the input is bad - this exception
     // is thrown in this case - a reference to errorBuffer.
     virtual std::string  RMMIX_JDLexception( const std::string& string ) = 0;
     
-    // Get a string out of the lineBuffer (if possible).
+    // Get the next token out of the current line (if possible).
     // Set lastOpertionOK according to whether successful or not,
     // then return lastOperationOK. Do not read a new line!
+    bool getToken( RMMIX_JDL::textView& token ) {
+        return ( lastOperationOK = lexer.nextToken( token ) );
+    }
     bool getToken( std::string& token );
     
     // protected:
@@ -146,7 +169,7 @@ public:
     // instructions or input (as the case may be).
     // This is where $JOB and $RUN are parsed (which is the same
     // in both objectCodeDecompiler and assemblyCompiler below).
-    bool gotoState(stateType newState);
+    virtual bool gotoState(stateType newState);
     virtual void prepareForState( stateType newState ) = 0; // extension specific
     
     // Finally, the instruction parser...
@@ -162,11 +185,45 @@ public:
  */
 class objectCodeDecompiler : public JobLangCompiler {
 public:
+    // A text object file is either mapped into memory and scanned in
+    // place, without copying a line or allocating anything (the default),
+    // or read line by line from inStream (the original reader, used when
+    // the file cannot be mapped, e.g. a pipe).
+    enum readerType { scanningReader, lineReader };
+
     // Constructor(s)
+    // If the file is in the binary object format (see RMMIXbinaryObject.h),
+    // it is mapped into memory, and the jobs are read from the image
+    // instead of being parsed.
+    objectCodeDecompiler(const char* fileName,
+                         readerType reader = scanningReader);
+
+    // The mapped file (or null, if the file is in the text format), the
+    // index of the current job in it, and the next instruction or input
+    // number to read
+    std::unique_ptr< RMMIX_JDL::binaryObjectImage > image;
+    int job = -1;
+    int position = 0;
+
+    // The scanned text file (or null), and the start of the next line in
+    // it.  atEOF and failed stand for inStream.eof() and inStream.fail().
+    std::unique_ptr< RMMIX_JDL::mappedFile > text;
+    const char* nextLine = nullptr;
+    bool atEOF  = false;
+    bool failed = false;
+
+    virtual bool eof() const {
+        return image ? ( 0 == image->jobs() ) 
+                     : text ? atEOF : inStream.eof();
+    }
 
-    objectCodeDecompiler(const char* fileName)
-    : JobLangCompiler(fileName) {
-    };
+    virtual bool good() const {
+        return image || ( text ? ! ( atEOF || failed ) : inStream.good() );
+    }
+
+    virtual objectCodeDecompiler& operator>>(RMMIXinstruction& instruction);
+    virtual objectCodeDecompiler& operator>>(int& inputNumber);
+    virtual bool gotoState(stateType newState);
 
     virtual std::string   RMMIX_JDLexception( const std::string& suffix ) {
         errorBuffer.str("");
@@ -181,6 +238,9 @@ public:
 
     virtual void buildJumpTable( ) { };
 
+    // The line reader's refillLineBuffer, for the scanned text
+    virtual bool refillLineBuffer();
+
     // protected:
     // Necessary virtual methods
     virtual bool getNumber(int &inputNumber);
@@ -226,11 +286,36 @@ public:
         return  errorBuffer.str() ;
     }
 
+    // Each job's code is assembled in one pass, when its $JOB is found
+    // (see buildJumpTable) - operator>> then returns the instructions
+    // one by one (or throws the errors found instead of them).
+    using JobLangCompiler::operator>>;
+    virtual assemblyCompiler& operator>>(RMMIXinstruction& instruction);
+
     // private:
     int instructionNumber = 0;
     RMMIX_JDL::SymbolTable      jumpTable;
     virtual void prepareForState( stateType newState ); 
     virtual void buildJumpTable( ); 
+
+    // The job's code: each instruction, or the error found in its line
+    struct assembledLine {
+        RMMIXinstruction instruction;
+        std::string      error;
+    };
+    std::vector< assembledLine > assembled;
+    std::size_t                  nextAssembled = 0;
+
+    // An operand naming a label that was not (yet) defined - patched
+    // once the whole job has been read
+    struct forwardReference {
+        std::size_t line;              // in assembled
+        int         field;             // in the instruction
+        int         instructionNumber; // when the operand was read
+        std::string label;
+    };
+    std::vector< forwardReference > forwardReferences;
+    int operandNumber = 0; // of the instruction being read
         
     // protected:
     // Necessary virtual methods
@@ -0,0 +1,234 @@
+// =====================================================================
+// RMMIXbinaryObject.cpp - Source Code file for the RMMIX binary object
+//                         format (see RMMIXbinaryObject.h)
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+
+#include <algorithm> // for std::max
+#include <cstring>   // for std::memchr
+#include <iterator>  // for std::make_move_iterator
+#include <sstream>
+
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap, munmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+
+#include "RMMIXbinaryObject.h"
+
+namespace {
+
+void writeWord( std::ostream& stream, std::int32_t word ) {
+    stream.write( reinterpret_cast< const char* >( &word ), sizeof word );
+} // end writeWord
+
+void writeWords( std::ostream& stream, const std::vector< std::int32_t >& words ) {
+    if ( ! words.empty() )
+        stream.write( reinterpret_cast< const char* >( words.data() ),
+                      std::streamsize( words.size() * sizeof( std::int32_t ) ) );
+} // end writeWords
+
+} // end anonymous namespace
+
+namespace RMMIX_JDL {
+
+// ==================================================== binaryObjectWriter
+
+void binaryObjectWriter::addJob( const std::string& name )
+{
+    jobs.push_back( job() );
+    jobs.back().name = name;
+} // end addJob
+
+void binaryObjectWriter::addInstruction( const RMMIXinstruction& instruction )
+{
+    for ( int field = 0; field < RMMIXinstruction::maxNumFields; ++field )
+        jobs.back().code.push_back( ( field < instruction.numFields )
+                                    ? instruction.fields[ field ] : 0 );
+} // end addInstruction
+
+void binaryObjectWriter::startInput( )
+{
+    jobs.back().hasInput = true;
+} // end startInput
+
+void binaryObjectWriter::addInput( int inputNumber )
+{
+    jobs.back().input.push_back( inputNumber );
+} // end addInput
+
+void binaryObjectWriter::addSymbols( const SymbolTable& labels )
+{
+    if ( withSymbols )
+        jobs.back().labels = labels;
+} // end addSymbols
+
+void binaryObjectWriter::append( binaryObjectWriter&& other )
+{
+    jobs.insert( jobs.end(), std::make_move_iterator( other.jobs.begin() ),
+                 std::make_move_iterator( other.jobs.end() ) );
+    other.jobs.clear();
+} // end append
+
+bool binaryObjectWriter::write( std::ostream& stream ) const
+{
+    // Lay out the sections, one job after the other - the names come last
+    std::vector< std::int32_t > table;
+    std::int32_t offset = 16 + 32 * std::int32_t( jobs.size() );
+    for ( const job& j : jobs ) {
+        std::int32_t code    = offset;
+        std::int32_t input   = code  + 4 * std::int32_t( j.code.size() );
+        std::int32_t symbols = input + 4 * std::int32_t( j.input.size() );
+        offset = symbols + 8 * std::int32_t( j.labels.size() );
+        table.insert( table.end(), {
+            0, code, std::int32_t( j.code.size() / 4 ),
+            input, j.hasInput ? std::int32_t( j.input.size() ) : noInput,
+            symbols, std::int32_t( j.labels.size() ), 0 } );
+    }; // end for all jobs
+    std::string names;
+    std::vector< std::vector< std::int32_t > > symbolTables;
+    for ( std::size_t j = 0; j < jobs.size(); ++j ) {
+        table[ 8 * j ] = offset + std::int32_t( names.size() );
+        names += jobs[ j ].name + '\0';
+        symbolTables.emplace_back( );
+        for ( const auto& label : jobs[ j ].labels ) {
+            symbolTables.back().push_back( offset + std::int32_t( names.size() ) );
+            symbolTables.back().push_back( label.second );
+            names += label.first + '\0';
+        }; // end for all labels
+    }; // end for all jobs
+    names.resize( ( names.size() + 3 ) / 4 * 4, '\0' );
+
+    writeWord( stream, binaryObjectMagic );
+    writeWord( stream, binaryObjectVersion );
+    writeWord( stream, std::int32_t( jobs.size() ) );
+    writeWord( stream, withSymbols ? binaryObjectSymbols : 0 );
+    writeWords( stream, table );
+    for ( std::size_t j = 0; j < jobs.size(); ++j ) {
+        writeWords( stream, jobs[ j ].code );
+        writeWords( stream, jobs[ j ].input );
+        writeWords( stream, symbolTables[ j ] );
+    }; // end for all jobs
+    stream.write( names.data(), std::streamsize( names.size() ) );
+    return stream.good();
+} // end write
+
+// ============================================================ mappedFile
+
+mappedFile::mappedFile( const char* filename )
+{
+    int fd = ::open( filename, O_RDONLY );
+    struct stat status;
+    if ( ( fd < 0 ) || ( 0 != ::fstat( fd, &status ) )
+         || ! S_ISREG( status.st_mode ) ) {
+        if ( 0 <= fd ) ::close( fd );
+        throw std::string( "Cannot open file " ) + filename
+              + " (or it is not a regular file)";
+    };
+    size = std::size_t( status.st_size );
+    void* mapped = size ? ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 )
+                        : nullptr; // cannot map nothing
+    ::close( fd ); // the mapping stays
+    if ( MAP_FAILED == mapped )
+        throw std::string( "Cannot map file " ) + filename;
+    address = mapped;
+} // end constructor
+
+mappedFile::~mappedFile( )
+{
+    if ( address ) ::munmap( address, size );
+} // end destructor
+
+// ===================================================== binaryObjectImage
+
+binaryObjectImage::binaryObjectImage( const char* filename )
+: file( filename )
+{
+    check( filename );
+} // end constructor
+
+void binaryObjectImage::check( const std::string& filename ) const
+{
+    const std::string error = "Bad binary object file " + filename + ": ";
+    const std::size_t size = file.size;
+    auto within = [ size ]( long long offset, long long bytes ) {
+        return ( 0 <= offset ) && ( 0 == offset % 4 ) && ( 0 <= bytes )
+               && ( offset + bytes <= (long long)( size ) );
+    };
+    auto isName = [ this, size ]( std::int32_t offset ) {
+        return ( 0 <= offset ) && ( std::size_t( offset ) < size )
+               && std::memchr( file.begin() + offset, '\0', size - offset );
+    };
+
+    if ( size < 16 )
+        throw error + "header truncated";
+    if ( ! isBinaryObjectMagic( header()[ 0 ] ) )
+        throw error + "not a binary object file";
+    if ( binaryObjectMagic != header()[ 0 ] )
+        throw error + "written on a machine with another byte order";
+    if ( binaryObjectVersion != header()[ 1 ] )
+        throw error + "version " + std::to_string( header()[ 1 ] )
+              + " (expected " + std::to_string( binaryObjectVersion ) + ")";
+    if ( ! within( 16, 32LL * jobs() ) )
+        throw error + "job table truncated";
+    for ( int job = 0; job < jobs(); ++job ) {
+        const std::int32_t* e = entry( job );
+        const std::string jobError = error + "job " + std::to_string( job ) + ": ";
+        if ( ! isName( e[ 0 ] ) )
+            throw jobError + "bad job name";
+        if ( ! within( e[ 1 ], 16LL * e[ 2 ] ) )
+            throw jobError + "code section truncated";
+        if ( ( e[ 4 ] < noInput ) || ! within( e[ 3 ], 4LL * std::max( e[ 4 ], 0 ) ) )
+            throw jobError + "input section truncated";
+        if ( ! within( e[ 5 ], 8LL * e[ 6 ] ) )
+            throw jobError + "symbol table truncated";
+        for ( int symbol = 0; symbol < e[ 6 ]; ++symbol )
+            if ( ! isName( at( e[ 5 ] )[ 2 * symbol ] ) )
+                throw jobError + "bad label";
+    }; // end for all jobs
+} // end check
+
+const char* binaryObjectImage::jobName( int job ) const
+{
+    return reinterpret_cast< const char* >( at( entry( job )[ 0 ] ) );
+} // end jobName
+
+RMMIXinstruction binaryObjectImage::instruction( int job, int number ) const
+{
+    const std::int32_t* fields = at( entry( job )[ 1 ] ) + 4 * number;
+    if ( ! opCodeOK( fields[ 0 ] ) ) {
+        std::stringstream error;
+        error << "Illegal op code " << fields[ 0 ] << " in instruction "
+              << number << " of job " << jobName( job );
+        throw error.str();
+    };
+    int numOperands = numberOfOperands( fields[ 0 ] );
+    return RMMIXinstruction( fields[ 0 ], numOperands,
+                             ( 0 < numOperands ) ? fields[ 1 ] : 0,
+                             ( 1 < numOperands ) ? fields[ 2 ] : 0,
+                             ( 2 < numOperands ) ? fields[ 3 ] : 0 );
+} // end instruction
+
+const char* binaryObjectImage::symbolName( int job, int number ) const
+{
+    return reinterpret_cast< const char* >(
+               at( at( entry( job )[ 5 ] )[ 2 * number ] ) );
+} // end symbolName
+
+} // end of RMMIX_JDL namespace
@@ -0,0 +1,176 @@
+// =====================================================================
+// RMMIXbinaryObject.h - Header file for the RMMIX binary object format
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file RMMIXbinaryObject.h
+//
+// Besides the text object format ($JOB, hex numbers, $RUN, ..., $END),
+// the assembler can write the same jobs in a binary object format
+// (rmmixas --binary), which the simulator maps into memory and reads
+// without parsing a single line.  Every field is a 32 bit word, in the
+// byte order of the machine that wrote the file; all offsets are in
+// bytes, from the start of the file:
+//
+//   header      magic ("RMXB"), version, number of jobs, flags
+//               (bit 0: the file contains symbol tables)
+//   job table   8 words per job: name, code, instructions, input,
+//               input words, symbols, number of symbols, 0
+//   code        4 words per instruction: op code, up to 3 operands
+//               (unused operands are 0)
+//   input       1 word per input number - a job without $RUN has no
+//               input section (input words = noInput)
+//   symbols     2 words per label: name, instruction number
+//               (only with rmmixas --symbols)
+//   names       the job names and labels, each ending with a '\0'
+//
+// =====================================================================
+
+#ifndef RMMIXBINARYOBJECT_H_
+#define RMMIXBINARYOBJECT_H_
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for std::int32_t
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "RMMIXcodes.h"
+#include "RMMIXinstruction.h"
+
+namespace RMMIX_JDL {
+
+    const std::int32_t binaryObjectMagic   = 0x42584d52; // "RMXB" on disk
+    const std::int32_t binaryObjectVersion = 1;
+    const std::int32_t binaryObjectSymbols = 1;  // flag: symbol tables
+    const std::int32_t noInput             = -1; // no $RUN in the job
+
+    // True for the magic number in either byte order (so that a file
+    // written on another machine is recognized, and rejected as such)
+    inline bool isBinaryObjectMagic( std::int32_t word ) {
+        return ( binaryObjectMagic == word ) || ( 0x524d5842 == word );
+    }
+
+    /*  class: binaryObjectWriter
+     *******************************************************
+     *  Collects the jobs of one or more assembly files (used by the
+     *  assembler), then writes them in the binary object format.
+     */
+    class binaryObjectWriter {
+    public:
+        explicit binaryObjectWriter( bool withSymbols = false )
+        : withSymbols( withSymbols ) { };
+
+        // Each job starts with addJob, then come its instructions,
+        // then (after startInput, i.e. $RUN) its input.
+        void addJob( const std::string& name );
+        void addInstruction( const RMMIXinstruction& instruction );
+        void startInput( );
+        void addInput( int inputNumber );
+        void addSymbols( const SymbolTable& labels );
+
+        // Adds all of other's jobs, after the ones added so far
+        void append( binaryObjectWriter&& other );
+
+        bool empty( ) const { return jobs.empty(); }
+
+        // Writes all the jobs added so far, returns stream.good()
+        bool write( std::ostream& stream ) const;
+
+    private:
+        struct job {
+            std::string                 name;
+            std::vector< std::int32_t > code;  // 4 words per instruction
+            std::vector< std::int32_t > input;
+            bool                        hasInput = false;
+            SymbolTable                 labels;
+        };
+
+        bool               withSymbols;
+        std::vector< job > jobs;
+    }; // end binaryObjectWriter
+
+    /*  class: mappedFile
+     *******************************************************
+     *  A regular file, mapped into memory (read only) for as long as
+     *  the object lives.  The constructor throws a std::string if the
+     *  file cannot be mapped.
+     */
+    class mappedFile {
+    public:
+        explicit mappedFile( const char* filename );
+        ~mappedFile( );
+
+        mappedFile( const mappedFile& ) = delete;
+        mappedFile& operator=( const mappedFile& ) = delete;
+
+        const char* begin( ) const { return static_cast< const char* >( address ); }
+        const char* end( ) const { return begin() + size; }
+
+        void*       address = nullptr; // null if the file is empty
+        std::size_t size    = 0;
+    }; // end mappedFile
+
+    /*  class: binaryObjectImage
+     *******************************************************
+     *  A binary object file, mapped into memory (read only).  The
+     *  constructor checks that the header and every section lie within
+     *  the file, and throws a std::string if they do not - after that,
+     *  reading a job is just indexing into the image.
+     */
+    class binaryObjectImage {
+    public:
+        explicit binaryObjectImage( const char* filename );
+
+        int jobs( ) const { return header()[ 2 ]; }
+        const char* jobName( int job ) const;
+
+        int instructions( int job ) const { return entry( job )[ 2 ]; }
+        // Throws a std::string if the op code is not legal
+        RMMIXinstruction instruction( int job, int number ) const;
+
+        int inputWords( int job ) const { return entry( job )[ 4 ]; }
+        int input( int job, int number ) const {
+            return at( entry( job )[ 3 ] )[ number ];
+        }
+
+        int symbols( int job ) const { return entry( job )[ 6 ]; }
+        const char* symbolName( int job, int number ) const;
+        int symbolValue( int job, int number ) const {
+            return at( entry( job )[ 5 ] )[ 2 * number + 1 ];
+        }
+
+    private:
+        mappedFile file;
+
+        const std::int32_t* at( std::int32_t offset ) const {
+            return reinterpret_cast< const std::int32_t* >(
+                       file.begin() + offset );
+        }
+        const std::int32_t* header( ) const { return at( 0 ); }
+        const std::int32_t* entry( int job ) const {
+            return at( 16 + 32 * job );
+        }
+
+        void check( const std::string& filename ) const;
+    }; // end binaryObjectImage
+
+} // end of RMMIX_JDL namespace
+
+#endif /* RMMIXBINARYOBJECT_H_ */
@@ -29,7 +29,11 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint32_t
+#include <cstring> // for std::strncmp
 #include <map>
+#include <string>
 
 namespace RMMIX_JDL {
 
@@ -58,6 +62,123 @@ namespace RMMIX_JDL {
         return std::string( "" );
     }
 
+    // The op codes and trap codes below never change, though, so for them
+    // we can do better than a SymbolTable: they are kept in (constexpr)
+    // arrays of codeSymbols, in the order of their codes, so that the
+    // compiler can index them by code and hash them by name (see
+    // perfectHash).  The SymbolTables are built from these arrays.
+
+    struct codeSymbol {
+        const char* name;
+        int         code;
+    }; // end codeSymbol
+
+    inline SymbolTable symbolTable( const codeSymbol* begin, const codeSymbol* end ) {
+        SymbolTable table;
+        for ( const codeSymbol* symbol = begin; symbol < end; ++symbol )
+            table.emplace( symbol->name, symbol->code );
+        return table;
+    }
+
+    // ====================================>>>   Perfect Hashing
+    // A perfectHash finds the code of a name with one hash and (at most)
+    // one string compare.  The compiler does all the work: it tries seeds
+    // for the (FNV-1a) hash until no two symbols of the array land in the
+    // same slot, then fills in which symbol is in which slot.
+    // (C++11 constexpr functions must be a single return statement, hence
+    // all the recursion.)
+
+    constexpr std::uint32_t symbolHash( const char* name, std::size_t length,
+                                        std::uint32_t hash ) {
+        return ( 0 == length ) ? hash
+               : symbolHash( name + 1, length - 1,
+                             ( hash ^ (unsigned char)( *name ) ) * 16777619u );
+    }
+
+    constexpr std::size_t nameLength( const char* name ) {
+        return ( '\0' == *name ) ? 0 : 1 + nameLength( name + 1 );
+    }
+
+    constexpr int hashSlot( const char* name, std::size_t length,
+                            std::uint32_t seed, int slotBits ) {
+        return int( symbolHash( name, length, seed ) >> ( 32 - slotBits ) );
+    }
+
+    constexpr int hashSlot( const codeSymbol& symbol, std::uint32_t seed, int slotBits ) {
+        return hashSlot( symbol.name, nameLength( symbol.name ), seed, slotBits );
+    }
+
+    // Does symbols[ i ] share its slot with one of the first n symbols?
+    constexpr bool sharesSlot( const codeSymbol* symbols, std::size_t i, std::size_t n,
+                               std::uint32_t seed, int slotBits ) {
+        return ( 0 < n )
+               && ( ( hashSlot( symbols[ i ], seed, slotBits )
+                      == hashSlot( symbols[ n - 1 ], seed, slotBits ) )
+                    || sharesSlot( symbols, i, n - 1, seed, slotBits ) );
+    }
+
+    // Is every one of the first n symbols alone in its slot?
+    constexpr bool isPerfect( const codeSymbol* symbols, std::size_t n,
+                              std::uint32_t seed, int slotBits ) {
+        return ( 0 == n )
+               || ( ! sharesSlot( symbols, n - 1, n - 1, seed, slotBits )
+                    && isPerfect( symbols, n - 1, seed, slotBits ) );
+    }
+
+    constexpr std::uint32_t perfectSeed( const codeSymbol* symbols, std::size_t size,
+                                         std::uint32_t seed, int slotBits ) {
+        return isPerfect( symbols, size, seed, slotBits ) ? seed
+               : perfectSeed( symbols, size, seed + 1, slotBits );
+    }
+
+    // Which of the first n symbols is in the slot? (-1 if none)
+    constexpr int symbolInSlot( const codeSymbol* symbols, std::size_t n, int slot,
+                                std::uint32_t seed, int slotBits ) {
+        return ( 0 == n ) ? -1
+               : ( slot == hashSlot( symbols[ n - 1 ], seed, slotBits ) ) ? int( n - 1 )
+               : symbolInSlot( symbols, n - 1, slot, seed, slotBits );
+    }
+
+    // The slots 0, 1, ... n-1, as a parameter pack (cf. C++14's std::make_index_sequence)
+    template< int... slot > struct slotSequence { };
+    template< int n, int... slot > struct makeSlots : makeSlots< n - 1, n - 1, slot... > { };
+    template< int... slot > struct makeSlots< 0, slot... > {
+        typedef slotSequence< slot... > type;
+    };
+
+    template< const codeSymbol* symbols, std::size_t size, int slotBits,
+              typename = typename makeSlots< 1 << slotBits >::type >
+    struct perfectHash;
+
+    template< const codeSymbol* symbols, std::size_t size, int slotBits, int... slot >
+    struct perfectHash< symbols, size, slotBits, slotSequence< slot... > > {
+        static constexpr std::uint32_t seed
+            = perfectSeed( symbols, size, 2166136261u, slotBits );
+        static constexpr signed char symbolIn[ sizeof...( slot ) ]
+            = { symbolInSlot( symbols, size, slot, seed, slotBits )... };
+
+        // The code of the name (which need not end in '\0'), -1 if not found
+        static int lookup( const char* name, std::size_t length ) {
+            const int i = symbolIn[ hashSlot( name, length, seed, slotBits ) ];
+            return ( ( 0 <= i ) && ( 0 == std::strncmp( symbols[ i ].name, name, length ) )
+                     && ( '\0' == symbols[ i ].name[ length ] ) ) ? symbols[ i ].code : -1;
+        }
+    }; // end perfectHash
+
+    template< const codeSymbol* symbols, std::size_t size, int slotBits, int... slot >
+    constexpr std::uint32_t
+    perfectHash< symbols, size, slotBits, slotSequence< slot... > >::seed;
+
+    template< const codeSymbol* symbols, std::size_t size, int slotBits, int... slot >
+    constexpr signed char
+    perfectHash< symbols, size, slotBits, slotSequence< slot... > >::symbolIn[];
+
+    // Are the codes of the n symbols in ascending order, starting with first?
+    constexpr bool inCodeOrder( const codeSymbol* symbols, std::size_t n, int first ) {
+        return ( 0 == n ) || ( ( symbols[ n - 1 ].code == first + int( n - 1 ) )
+                               && inCodeOrder( symbols, n - 1, first ) );
+    }
+
     // ====================================>>>   The  Operation Codes (OpCodes)
     // First, the op codes (numeric values).
 
@@ -85,10 +206,18 @@ namespace RMMIX_JDL {
         maxOpCode = 0x14 // not an op code!
     };
 
-    // Next the symbolic names of the op codes,
-    // Stored in a SymbolTable.  
-    // Note use of C++11 Initializer list!
-    const SymbolTable opCodes{
+    // ====================================>>>   The  Pseudo Operation Codes (OpCodes)
+
+    enum pseudoOpCode_type { 
+        JMP = 0xb,
+        BEQZ = 0xc,
+        BNEZ = 0xd,
+        BNEG = 0xe
+    }; // end pseudoOpCode_type
+
+    // Next the symbolic names of the op codes, indexed by op code,
+    // followed by those of the pseudo op codes.
+    constexpr codeSymbol opSymbols[] = {
         { "NOP", NOP },
         { "MOV", MOV },
         { "MOVI", MOVI },
@@ -108,68 +237,80 @@ namespace RMMIX_JDL {
         { "LDWI", LDWI },
         { "LDW", LDW },
         { "STWI", STWI },
-        { "STW", STW }           
-    }; // end opCodes (constant symbol table)
+        { "STW", STW },
+        // pseudo op codes
+        { "JMP", JMP },
+        { "BEQZ", BEQZ },
+        { "BNEZ", BNEZ },
+        { "BNEG", BNEG }
+    }; // end opSymbols
+    constexpr std::size_t numberOfOpSymbols = sizeof( opSymbols ) / sizeof( opSymbols[ 0 ] );
+    static_assert( inCodeOrder( opSymbols, maxOpCode, NOP ),
+                   "opSymbols must be indexed by op code" );
+
+    // Stored in a SymbolTable, too.
+    const SymbolTable opCodes = symbolTable( opSymbols, opSymbols + maxOpCode );
+    const SymbolTable pseudoOpCodes = symbolTable( opSymbols + maxOpCode,
+                                                   opSymbols + numberOfOpSymbols );
 
     // Function to check of an opCode is legal                                
 
-    inline bool opCodeOK(opCode_type opCode) {
+    constexpr bool opCodeOK(opCode_type opCode) {
         return ((NOP <= opCode) && (opCode < maxOpCode));
     }
 
-    inline bool opCodeOK( int opCode ) { 
-        return opCodeOK( opCode_type( opCode )); 
-    }
-    
-    // Function returns the number of operands to expect for a given op code
-    // (thus - 0 <= return value <= 3 ).
-
-    inline int numberOfOperands(opCode_type opCode ) {
-        assert(opCodeOK(opCode));
-        switch (opCode) {
-            case NOP: return 0;
-            case JMPI: return 1;
-            case TRAP: // except for TRAP dump, which takes only 1 op...  ;-(
-            case MOV:
-            case MOVI:
-            case BEQZI:
-            case BNEZI:
-            case BNEGI:
-            case LDWI:
-            case LDW:
-            case STWI:
-            case STW: return 2;
-            case ADD:
-            case ADDI:
-            case SUB:
-            case SUBI:
-            case MUL:
-            case MULI:
-            case DIV:
-            case DIVI: return 3;
-            default: assert(false); // we should never get here
-        }; // end switch on opCOde 
-    }; // end numberOfOperands
+    constexpr bool opCodeOK( int opCode ) { 
+        return ((NOP <= opCode) && (opCode < maxOpCode));
+    }
 
-    inline int numberOfOperands( int opCode ) {
-        return numberOfOperands( opCode_type( opCode ) );
+    // The name of an op code ("" if it is not one)
+    constexpr const char* opCodeName( int opCode ) {
+        return opCodeOK( opCode ) ? opSymbols[ opCode ].name : "";
     }
 
-    // ====================================>>>   The  Pseudo Operation Codes (OpCodes)
+    // The op code (or pseudo op code) with the given name, -1 if none
+    inline int lookupOpCode( const char* name, std::size_t length ) {
+        return perfectHash< opSymbols, numberOfOpSymbols, 6 >::lookup( name, length );
+    }
 
-    enum pseudoOpCode_type { 
-        JMP = 0xb,
-        BEQZ = 0xc,
-        BNEZ = 0xd,
-        BNEG = 0xe
-    }; // end pseudoOpCode_type
+    // The number of operands to expect for a given op code
+    // (thus - 0 <= numberOfOperands( opCode ) <= 3 ), indexed by op code.
 
-    const SymbolTable pseudoOpCodes{
-        { "JMP", JMP },
-        { "BEQZ", BEQZ },
-        { "BNEZ", BNEZ },
-        { "BNEG", BNEG }
-    }; // end pseudoOpCodes 
+    constexpr int operandCounts[] = {
+        0,                      // NOP
+        2, 2,                   // MOV, MOVI
+        3, 3, 3, 3, 3, 3, 3, 3, // ADD, ADDI, SUB, SUBI, MUL, MULI, DIV, DIVI
+        1,                      // JMPI
+        2, 2, 2,                // BEQZI, BNEZI, BNEGI
+        2,                      // TRAP - except for TRAP dump, which takes only 1 op...  ;-(
+        2, 2, 2, 2              // LDWI, LDW, STWI, STW
+    }; // end operandCounts
+    static_assert( maxOpCode == sizeof( operandCounts ) / sizeof( operandCounts[ 0 ] ),
+                   "operandCounts must be indexed by op code" );
+
+    constexpr int numberOfOperands( int opCode ) {
+        return assert( opCodeOK( opCode ) ), operandCounts[ opCode ];
+    }; // end numberOfOperands
+
+    // Which operand (1-3) of an op code is an immediate value rather than a
+    // register number (0 = none), indexed by op code.  (TRAP's trap code
+    // counts as a register here, its data as the immediate value.)
+
+    constexpr int immediateOperands[] = {
+        0,                      // NOP
+        0, 2,                   // MOV, MOVI
+        0, 3, 0, 3, 0, 3, 0, 3, // ADD, ADDI, SUB, SUBI, MUL, MULI, DIV, DIVI
+        1,                      // JMPI
+        2, 2, 2,                // BEQZI, BNEZI, BNEGI
+        2,                      // TRAP
+        2, 0, 2, 0              // LDWI, LDW, STWI, STW
+    }; // end immediateOperands
+    static_assert( maxOpCode == sizeof( immediateOperands ) / sizeof( immediateOperands[ 0 ] ),
+                   "immediateOperands must be indexed by op code" );
+
+    constexpr int immediateOperand( int opCode ) {
+        return assert( opCodeOK( opCode ) ), immediateOperands[ opCode ];
+    }; // end immediateOperand
 
     // ====================================>>>   The Trap Codes
 
@@ -178,28 +319,66 @@ namespace RMMIX_JDL {
         HALT = 1,
         GETW = 2,
         PUTW = 3,
+        GETB = 4, // block I/O: TRAP getb, X reads $X+1 words into memory @ $X
+        PUTB = 5, // block I/O: TRAP putb, X writes them (see rmmixDMADevice)
+        RING   = 6, // asynchronous I/O: TRAP ring, X sets up $X+1 entries @ $X,
+        SUBMIT = 7, // TRAP submit, X starts the requests queued there, and
+        REAP   = 8, // TRAP reap, X waits for completions (see rmminixos.h)
         // Internal (Hardware) Trap Codes - not intended to be used in programs
         FATAL      = 65,
         GETW_READY = 66,
         PUTW_READY = 67,
-        maxTrapCode = 68 // should be greater than max(op)
+        TIMER      = 68, // the time slice (quantum) of the current job is over
+        BLOCK_READY = 69, // a GETB or PUTB is done
+        maxTrapCode = 70 // should be greater than max(op)
     }; // end trapCode_type
 
-    const SymbolTable trapCodes{
+    // The names of the software trap codes (HALT on),
+    // followed by those of the hardware trap codes (FATAL on)
+    constexpr codeSymbol trapSymbols[] = {
         { "halt", HALT  }, 
         { "getw", GETW  },
         { "putw", PUTW  },
+        { "getb", GETB  },
+        { "putb", PUTB  },
+        { "ring", RING  },
+        { "submit", SUBMIT },
+        { "reap", REAP  },
         { "FATAL",      FATAL  },
         { "GETW READY", GETW_READY },
-        { "PUTW READY", PUTW_READY }
-    }; // end pseudoOpCodes 
+        { "PUTW READY", PUTW_READY },
+        { "TIMER",      TIMER },
+        { "BLOCK READY", BLOCK_READY }
+    }; // end trapSymbols
+    constexpr std::size_t numberOfTrapSymbols = sizeof( trapSymbols ) / sizeof( trapSymbols[ 0 ] );
+    constexpr std::size_t numberOfSoftwareTraps = REAP - HALT + 1;
+    static_assert( inCodeOrder( trapSymbols, numberOfSoftwareTraps, HALT )
+                   && inCodeOrder( trapSymbols + numberOfSoftwareTraps,
+                                   numberOfTrapSymbols - numberOfSoftwareTraps, FATAL ),
+                   "trapSymbols must be in the order of their trap codes" );
+
+    const SymbolTable trapCodes = symbolTable( trapSymbols, trapSymbols + numberOfTrapSymbols );
+
+    constexpr bool trapCodeOK(trapCode_type trapCode) {
+        return ((HALT <= trapCode) && (trapCode < maxTrapCode));
+    }
 
-    inline bool trapCodeOK(trapCode_type trapCode) {
+    constexpr bool trapCodeOK( int trapCode) {
         return ((HALT <= trapCode) && (trapCode < maxTrapCode));
     }
 
-    inline bool trapCodeOK( int trapCode) {
-        return trapCodeOK( trapCode_type( trapCode ) );
+    // The name of a trap code ("" if it has none)
+    constexpr const char* trapCodeName( int trapCode ) {
+        return ( ( HALT <= trapCode ) && ( trapCode <= REAP ) )
+               ? trapSymbols[ trapCode - HALT ].name
+               : ( ( FATAL <= trapCode ) && ( trapCode <= BLOCK_READY ) )
+               ? trapSymbols[ numberOfSoftwareTraps + ( trapCode - FATAL ) ].name
+               : "";
+    }
+
+    // The trap code with the given name, -1 if none
+    inline int lookupTrapCode( const char* name, std::size_t length ) {
+        return perfectHash< trapSymbols, numberOfTrapSymbols, 5 >::lookup( name, length );
     }
 
 } // end RMMIX_JDL namespace
@@ -69,10 +69,53 @@ std::string RMMIXinstruction::dump() const
     outStream << "Instruction: " << std::flush;
     if (0 < numFields)
         outStream << " op = "
-            << RMMIX_JDL::lookup( RMMIX_JDL::opCodes, fields[ 0 ] )
+            << RMMIX_JDL::opCodeName( fields[ 0 ] )
             << ", " << numFields << " fields" << std::flush;
     for (int i = 0; i < numFields; ++i)
         outStream << " [" << i << "]=" << fields[ i ] << std::flush;
     return outStream.str();
 }; // end dump()
 
+// Packed instructions and programs (for the simulator)
+
+bool packedInstruction::pack( const RMMIXinstruction& instruction )
+{
+    const int opCode = instruction.opCode();
+    if ( ! RMMIX_JDL::opCodeOK( opCode )
+         || ( RMMIX_JDL::numberOfOperands( opCode ) + 1 != instruction.numFields ) )
+        return false;
+    packedInstruction packed;
+    packed.opCode = std::uint8_t( opCode );
+    packed.immediate = 0;
+    for ( int field = 1; field < RMMIXinstruction::maxNumFields; ++field ) {
+        const int value = instruction.fields[ field ];
+        if ( field == RMMIX_JDL::immediateOperand( opCode ) ) {
+            packed.immediate = value;
+            packed.operands[ field - 1 ] = 0;
+        }
+        else if ( ( 0 <= value ) && ( value <= 0xff ) )
+            packed.operands[ field - 1 ] = std::uint8_t( value );
+        else
+            return false;
+    }; // end for all operands
+    *this = packed;
+    return true;
+} // end pack
+
+packedProgram::packedProgram( const std::vector< RMMIXinstruction >& program )
+{
+    code.reserve( program.size() );
+    for ( const RMMIXinstruction& instruction : program )
+        push_back( instruction );
+} // end constructor
+
+void packedProgram::push_back( const RMMIXinstruction& instruction )
+{
+    packedInstruction packed;
+    if ( ! packed.pack( instruction ) ) {
+        packed.opCode = packedInstruction::wide;
+        packed.immediate = std::int32_t( wide.size() );
+        wide.push_back( instruction );
+    };
+    code.push_back( packed );
+} // end push_back
@@ -32,9 +32,14 @@
 #ifndef RMMIXINSTRUCTION_H_
 #define RMMIXINSTRUCTION_H_
 
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t, std::int32_t
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <vector>
+
+#include "RMMIXcodes.h"
 
 // An RMMIX Instruction contains an op code and 0-3 operands (parameters)
 // The op code could be stored as a byte, but this is a simulator, not real 
@@ -81,5 +86,75 @@ public:
 
 }; // end RMMIXinstruction
 
+// The assembler works with RMMIXinstructions, but the simulator keeps its
+// programs packed: 8 bytes per instruction instead of 20, so that more of
+// them stay in the cache.  The op code (5 bits) and the register operands
+// (a byte each) take up one word, the immediate operand (if the op code
+// has one, see RMMIX_JDL::immediateOperand) the other.
+
+struct packedInstruction {
+    // In place of an op code: the instruction did not fit (e.g. a register
+    // number greater than 255), the immediate is its index in
+    // packedProgram::wide.
+    static const std::uint8_t wide = 0x80;
+
+    std::uint8_t opCode;
+    std::uint8_t operands[ RMMIXinstruction::maxNumFields - 1 ]; // = fields[1-3]
+    std::int32_t immediate; // replaces the operand which is immediate
+
+    // Returns false if the instruction does not fit (this is left alone)
+    bool pack( const RMMIXinstruction& instruction );
+
+    // Only for instructions which fit, of course
+    RMMIXinstruction unpack( ) const {
+        RMMIXinstruction instruction;
+        instruction.numFields = RMMIX_JDL::numberOfOperands( opCode ) + 1;
+        instruction.fields[ 0 ] = opCode;
+        for ( int field = 1; field < RMMIXinstruction::maxNumFields; ++field )
+            instruction.fields[ field ] = operands[ field - 1 ];
+        if ( RMMIX_JDL::immediateOperand( opCode ) )
+            instruction.fields[ RMMIX_JDL::immediateOperand( opCode ) ] = immediate;
+        return instruction;
+    }
+}; // end packedInstruction
+
+static_assert( 8 == sizeof( packedInstruction ), "instructions must pack into 8 bytes" );
+
+// A program (i.e. a code segment), packed.  Used like a vector of
+// RMMIXinstructions, except that [] returns a copy, unpacked.
+class packedProgram {
+public:
+    packedProgram( ) { }
+    explicit packedProgram( const std::vector< RMMIXinstruction >& program );
+
+    void push_back( const RMMIXinstruction& instruction );
+
+    RMMIXinstruction operator[]( std::size_t address ) const {
+        const packedInstruction& packed = code[ address ];
+        return ( packedInstruction::wide == packed.opCode )
+               ? wide[ packed.immediate ] : packed.unpack();
+    }
+
+    std::size_t size( ) const { return code.size(); }
+
+    void clear( ) {
+        code.clear();
+        wide.clear();
+        unverified.clear();
+    }
+
+    // The addresses (in order) of the instructions which failed
+    // verification - filled in by the OS when it loads the program (see
+    // rmmixCPU::verify).  These are the ones the CPU must check.
+    std::vector< int > unverified;
+
+    bool verified( ) const { return unverified.empty(); }
+
+private:
+    std::vector< packedInstruction > code;
+    std::vector< RMMIXinstruction >  wide; // the instructions which did not fit
+
+}; // end packedProgram
+
 
 #endif /*RMMIXINSTRUCTION_H_*/
@@ -0,0 +1,116 @@
+// =====================================================================
+// RMMIXlexer.cpp - Source Code file for the lexer of the RMMIX JDL
+//                  readers (see RMMIXlexer.h)
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+
+#include <algorithm> // for std::replace, std::min
+#include <cstring>   // for std::memchr, std::memcmp, std::strlen
+
+#include "RMMIXlexer.h"
+
+namespace {
+
+inline int digitValue( char c, int base ) {
+    if ( ( '0' <= c ) && ( c <= '9' ) ) return c - '0';
+    if ( 10 == base ) return -1;
+    if ( ( 'a' <= c ) && ( c <= 'f' ) ) return c - 'a' + 10;
+    if ( ( 'A' <= c ) && ( c <= 'F' ) ) return c - 'A' + 10;
+    return -1;
+} // end digitValue
+
+} // end anonymous namespace
+
+namespace RMMIX_JDL {
+
+bool parseNumber( const char*& cursor, const char* end, int base, int& number )
+{
+    bool negative = ( cursor < end ) && ( '-' == *cursor );
+    if ( ( cursor < end ) && ( ( '-' == *cursor ) || ( '+' == *cursor ) ) )
+        ++cursor;
+    if ( ( 16 == base ) && ( cursor + 1 < end ) && ( '0' == cursor[ 0 ] )
+         && ( ( 'x' == cursor[ 1 ] ) || ( 'X' == cursor[ 1 ] ) ) )
+        cursor += 2;
+    const long long limit = negative ? 0x80000000LL : 0x7fffffffLL;
+    long long magnitude = 0;
+    const char* digits = cursor;
+    for ( int digit; ( cursor < end ) && ( 0 <= ( digit = digitValue( *cursor, base ) ) );
+          ++cursor )
+        magnitude = std::min( base * magnitude + digit, limit + 1 );
+    if ( ( digits == cursor ) || ( limit < magnitude ) )
+        return false;
+    number = int( negative ? -magnitude : magnitude );
+    return true;
+} // end parseNumber
+
+// =============================================================== lineLexer
+
+bool lineLexer::scan( const char* begin, const char* end )
+{
+    line = begin;
+    while ( ( line < end ) && std::isspace( (unsigned char)( *line ) ) )
+        ++line;
+    const char* comment = static_cast< const char* >(
+        std::memchr( line, commentDelimiter, end - line ) );
+    lineEnd = comment ? comment : end;
+    while ( ( line < lineEnd ) && isSeparator( lineEnd[ -1 ] ) )
+        --lineEnd;
+    cursor = line;
+    return line < lineEnd;
+} // end scan
+
+std::string lineLexer::text( ) const
+{
+    std::string cleaned( line, lineEnd );
+    std::replace( cleaned.begin(), cleaned.end(), ',', ' ' );
+    return cleaned;
+} // end text
+
+bool lineLexer::isKeyword( const char* keyword ) const
+{
+    if ( ( line == lineEnd ) || ( '$' != *line ) ) return false;
+    const char* end = line;
+    while ( ( end < lineEnd ) && ! isSeparator( *end ) )
+        ++end;
+    return ( std::size_t( end - line ) == std::strlen( keyword ) )
+           && ( 0 == std::memcmp( line, keyword, end - line ) );
+} // end isKeyword
+
+bool lineLexer::nextToken( textView& token )
+{
+    while ( ( cursor < lineEnd ) && isSeparator( *cursor ) )
+        ++cursor;
+    token.begin = cursor;
+    while ( ( cursor < lineEnd ) && ! isSeparator( *cursor ) )
+        ++cursor;
+    token.end = cursor;
+    return ! token.empty();
+} // end nextToken
+
+bool lineLexer::nextNumber( int& number, int base )
+{
+    while ( ( cursor < lineEnd ) && isSeparator( *cursor ) )
+        ++cursor;
+    bool OK = parseNumber( cursor, lineEnd, base, number );
+    if ( ! OK )
+        cursor = lineEnd;
+    return OK;
+} // end nextNumber
+
+} // end of RMMIX_JDL namespace
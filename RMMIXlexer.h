@@ -0,0 +1,105 @@
+// =====================================================================
+// RMMIXlexer.h - Header file for the lexer of the RMMIX JDL readers
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file RMMIXlexer.h
+//
+// Both job language readers (the assemblyCompiler and the
+// objectCodeDecompiler, see RMMIXJobLang.h) read their input one line at
+// a time.  The lexer cleans each line up - leading and trailing white
+// space and comments (from '%' on) do not count - and splits it into
+// tokens, separated by white space or commas.
+//
+// All this happens in place: the line, and each token in it, is just a
+// pair of pointers into text that belongs to somebody else (the mapped
+// file, or the line just read), so nothing is erased, copied into a
+// stream or allocated.
+//
+// =====================================================================
+
+#ifndef RMMIXLEXER_H_
+#define RMMIXLEXER_H_
+
+#include <cctype>   // for std::isspace
+#include <cstddef>  // for std::size_t
+#include <string>
+
+namespace RMMIX_JDL {
+
+    const char commentDelimiter = '%';
+
+    // In a line, commas separate tokens just like white space does
+    inline bool isSeparator( char c ) {
+        return std::isspace( (unsigned char)( c ) ) || ( ',' == c );
+    }
+
+    /*  struct: textView
+     *******************************************************
+     *  A piece of text that belongs to somebody else - valid only as long
+     *  as the text is (cf. C++17's std::string_view).
+     */
+    struct textView {
+        const char* begin = nullptr;
+        const char* end   = nullptr;
+
+        bool        empty( ) const { return begin == end; }
+        std::size_t size( )  const { return std::size_t( end - begin ); }
+        std::string str( )   const { return std::string( begin, end ); }
+    }; // end textView
+
+    // Reads an int from the text starting at cursor (and ending before
+    // end), just as std::istream's >> does with std::dec (base 10) or
+    // std::hex (base 16): an optional sign, in base 16 an optional 0x,
+    // digits, and nothing out of an int's range.  Leaves cursor after the
+    // characters read, returns false if there was no (valid) number.
+    bool parseNumber( const char*& cursor, const char* end, int base,
+                      int& number );
+
+    /*  class: lineLexer
+     *******************************************************
+     *  The current line of a reader, and how much of it has been read.
+     */
+    class lineLexer {
+    public:
+        // Cleans up the line from begin to end (not including the '\n');
+        // returns false if nothing is left (i.e. the line is blank)
+        bool scan( const char* begin, const char* end );
+        void clear( ) { line = lineEnd = cursor = nullptr; }
+
+        // The cleaned up line, with commas as spaces (for error messages)
+        std::string text( ) const;
+
+        // Is the line the job control line keyword (e.g. "$RUN")?
+        bool isKeyword( const char* keyword ) const;
+
+        // The next token, or number (see parseNumber) - false if there is
+        // none.  As in a stream, after a bad number the line is used up.
+        bool nextToken( textView& token );
+        bool nextNumber( int& number, int base );
+
+    private:
+        const char* line    = nullptr;
+        const char* lineEnd = nullptr;
+        const char* cursor  = nullptr; // the next character to read
+    }; // end lineLexer
+
+} // end of RMMIX_JDL namespace
+
+#endif /* RMMIXLEXER_H_ */
@@ -0,0 +1,207 @@
+// =====================================================================
+// rmminixOutput.cpp - Source code for the output channels of the OS.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Source File for rmminixOutput.h
+// See rmminixOutput.h for more information
+//
+// =====================================================================
+
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap, munmap
+#include <unistd.h>   // for write, ftruncate, close
+
+#include "rmminixOutput.h"
+
+namespace rmminixOS {
+
+// Both writers are stream buffers: the stream puts characters into the
+// buffer (pbase() .. epptr()) until it is full, then calls overflow.
+class outputChannel::channelWriter : public std::streambuf {
+public:
+    channelWriter( int fileDescriptor ) : fd( fileDescriptor ) { };
+    virtual ~channelWriter( ) { };
+
+    // Writes everything out and closes the file (once) - false if
+    // anything went wrong, now or before.
+    virtual bool close( ) = 0;
+
+protected:
+    int  fd;
+    bool failed = false;
+}; // end channelWriter
+
+// The buffered writer writes the buffer to the file when it is full
+// (or when the channel is closed).
+class outputChannel::fileWriter final : public outputChannel::channelWriter {
+public:
+    fileWriter( int fileDescriptor )
+    : channelWriter( fileDescriptor ), buffer( bufferSize ) {
+        setp( buffer.data(), buffer.data() + buffer.size() );
+    };
+
+    virtual bool close( ) {
+        writeBuffer();
+        failed = ( 0 != ::close( fd ) ) || failed;
+        return ! failed;
+    };
+
+protected:
+    virtual int_type overflow( int_type c ) {
+        if ( ! writeBuffer() )
+            return traits_type::eof();
+        if ( ! traits_type::eq_int_type( c, traits_type::eof() ) ) {
+            *pptr() = traits_type::to_char_type( c );
+            pbump( 1 );
+        };
+        return traits_type::not_eof( c );
+    };
+
+private:
+    static const int bufferSize = 64 * 1024;
+
+    std::vector< char > buffer;
+
+    bool writeBuffer( ) {
+        for ( char* next = pbase(); ( next < pptr() ) && ! failed; ) {
+            ssize_t written = ::write( fd, next, pptr() - next );
+            if ( written <= 0 )
+                failed = true;
+            else
+                next += written;
+        };
+        setp( buffer.data(), buffer.data() + buffer.size() );
+        return ! failed;
+    };
+}; // end fileWriter
+
+// The mmap writer maps a window of the file into memory, and writes
+// straight into it.  When the window is full, the file grows by another
+// window, and the next one is mapped.  When the channel is closed, the
+// file is cut back to the output actually written.
+class outputChannel::mapWriter final : public outputChannel::channelWriter {
+public:
+    mapWriter( int fileDescriptor ) : channelWriter( fileDescriptor ) {
+        mapWindow( 0 );
+    };
+
+    virtual bool close( ) {
+        off_t size = windowStart + ( pptr() - pbase() );
+        unmapWindow();
+        failed = ( 0 != ::ftruncate( fd, size ) ) || failed;
+        failed = ( 0 != ::close( fd ) ) || failed;
+        return ! failed;
+    };
+
+protected:
+    virtual int_type overflow( int_type c ) {
+        if ( failed || ! mapWindow( windowStart + windowSize ) )
+            return traits_type::eof();
+        if ( ! traits_type::eq_int_type( c, traits_type::eof() ) ) {
+            *pptr() = traits_type::to_char_type( c );
+            pbump( 1 );
+        };
+        return traits_type::not_eof( c );
+    };
+
+private:
+    static const off_t windowSize = 1024 * 1024; // a multiple of the page size
+
+    off_t windowStart = 0;
+    char* window = nullptr;
+
+    bool mapWindow( off_t start ) {
+        unmapWindow();
+        windowStart = start;
+        void* address = MAP_FAILED;
+        if ( 0 == ::ftruncate( fd, start + windowSize ) )
+            address = ::mmap( nullptr, windowSize, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, start );
+        if ( MAP_FAILED == address ) {
+            failed = true;
+            return false;
+        };
+        window = static_cast< char* >( address );
+        setp( window, window + windowSize );
+        return true;
+    };
+
+    void unmapWindow( ) {
+        if ( window )
+            ::munmap( window, windowSize );
+        window = nullptr;
+        setp( nullptr, nullptr );
+    };
+}; // end mapWriter
+
+// While the channel is closed, there is nowhere to write to (but the
+// stream is good, just as a std::ofstream which has not been opened).
+class outputChannel::closedWriter final : public std::streambuf {
+}; // end closedWriter - overflow always fails
+
+std::streambuf* outputChannel::closed( )
+{
+    static closedWriter nowhere;
+    return &nowhere;
+}
+
+
+outputChannel::outputChannel( writerType type )
+: std::ostream( closed() ), type( type )
+{ }
+
+outputChannel::~outputChannel( )
+{
+    close();
+}
+
+void outputChannel::open( const std::string& filename )
+{
+    close();
+    int fd = ::open( filename.c_str(), ( bufferedWriter == type )
+                                        ? O_WRONLY | O_CREAT | O_TRUNC
+                                        : O_RDWR | O_CREAT | O_TRUNC,
+                     0666 );
+    if ( fd < 0 ) {
+        setstate( badbit ); // until it is closed
+        return;
+    };
+    if ( bufferedWriter == type )
+        writer.reset( new fileWriter( fd ) );
+    else
+        writer.reset( new mapWriter( fd ) );
+    rdbuf( writer.get() ); // also clears the stream's state
+}
+
+bool outputChannel::close( )
+{
+    bool OK = ! bad();
+    if ( writer )
+        OK = writer->close() && OK;
+    rdbuf( closed() ); // also clears the stream's state
+    writer.reset();
+    return OK;
+}
+
+} // end of rmminixOS namespace
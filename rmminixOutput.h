@@ -0,0 +1,79 @@
+// =====================================================================
+// rmminixOutput.h - Header file for the output channels of the rmminix
+//                   operating system (simulator).
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file rmminixOutput.h
+//
+// An output channel is the stream a job's output device writes to (see
+// rmmixOutputDevice).  The OS opens it at the first PUTW of a subjob,
+// and closes it when the subjob halts or crashes (see closeOutput) -
+// only then is the output certain to be in the file.  In between, the
+// words are collected in memory by one of two writers:
+//
+//  buffered    a large buffer, written to the file whenever it is full
+//              (the default).
+//  mmap        the file itself, mapped into memory a window at a time
+//              (rmmixsim --output=mmap).
+//
+// =====================================================================
+
+#ifndef RMMINIXOUTPUT_H_
+#define RMMINIXOUTPUT_H_
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace rmminixOS {
+
+    class outputChannel : public std::ostream {
+    public:
+        enum writerType { bufferedWriter, mappedWriter };
+
+        outputChannel( writerType type = bufferedWriter );
+        ~outputChannel( ); // closes the channel
+
+        // Creates (or truncates) the file and starts writing to it.
+        // If that fails, the channel is bad (so writing to it fails)
+        // until it is closed.
+        void open( const std::string& filename );
+
+        bool is_open( ) const { return bool( writer ); }
+
+        // Writes everything out and closes the file.  Returns false if
+        // any output has been lost.
+        bool close( );
+
+    private:
+        class channelWriter; // see rmminixOutput.cpp
+        class fileWriter;
+        class mapWriter;
+        class closedWriter;
+
+        static std::streambuf* closed( );
+
+        writerType                       type;
+        std::unique_ptr< channelWriter > writer;
+    }; // end outputChannel
+
+} // end of rmminixOS namespace
+
+#endif /* RMMINIXOUTPUT_H_ */
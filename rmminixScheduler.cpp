@@ -0,0 +1,212 @@
+// =====================================================================
+// rmminixScheduler.cpp - Source code for the CPU scheduling policies.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Source File for rmminixScheduler.h
+// See rmminixScheduler.h for more information
+//
+// =====================================================================
+
+#include <set>
+#include <string>
+#include <utility> // for std::pair
+#include <vector>
+
+#include "rmmixHardware.h" // for the clock
+#include "rmminixScheduler.h"
+
+namespace {
+
+using rmminixOS::noJob;
+using rmminixOS::processControlBlock;
+using rmminixOS::jobQueue;
+
+// Round robin - one FIFO queue.  With a quantum of 0, the timer is never
+// used, and the jobs take turns only when they block or halt.
+class roundRobinPolicy : public rmminixOS::schedulingPolicy {
+public:
+    roundRobinPolicy( std::vector< processControlBlock >& table, int slice )
+    : schedulingPolicy( table ), ready( table ), slice( slice ) { };
+
+    virtual void add( int job )    { ready.push( job ); }
+    virtual void remove( int job ) { ready.remove( job ); }
+    virtual int  next( ) const     { return ready.front(); }
+
+    virtual int  quantum( int job ) const { return slice; }
+    virtual bool usesTimer( ) const       { return 0 < slice; }
+
+private:
+    jobQueue  ready;
+    const int slice;
+}; // end roundRobinPolicy
+
+// Static priorities - the earlier a job was named, the more important it
+// is, so the ready jobs are simply kept sorted by job number.
+class priorityPolicy : public rmminixOS::schedulingPolicy {
+public:
+    priorityPolicy( std::vector< processControlBlock >& table )
+    : schedulingPolicy( table ) {
+        for ( std::size_t job = 0; job < jobs.size(); ++job )
+            jobs[ job ].level = int( job );
+    };
+
+    virtual void add( int job )    { ready.insert( job ); }
+    virtual void remove( int job ) { ready.erase( job ); }
+    virtual int  next( ) const {
+        return ( ready.empty() ? noJob : *ready.begin() );
+    }
+
+    virtual bool preempts( int job, int current ) const {
+        return ( jobs[ job ].level < jobs[ current ].level );
+    }
+
+private:
+    std::set< int > ready;
+}; // end priorityPolicy
+
+// Multi-level feedback queue - one FIFO queue per level.
+class mlfqPolicy : public rmminixOS::schedulingPolicy {
+public:
+    static const int numberOfLevels = 3;
+    static const int boostFactor    = 50; // boost every 50 top-level quanta
+
+    mlfqPolicy( std::vector< processControlBlock >& table, int slice )
+    : schedulingPolicy( table ), slice( slice ) {
+        for ( int level = 0; level < numberOfLevels; ++level )
+            ready.emplace_back( table );
+        for ( processControlBlock& pcb : jobs )
+            pcb.level = 0; // everybody starts at the top
+    };
+
+    virtual void add( int job )    { ready[ jobs[ job ].level ].push( job ); }
+    virtual void remove( int job ) { ready[ jobs[ job ].level ].remove( job ); }
+    virtual int  next( ) const {
+        for ( const jobQueue& queue : ready )
+            if ( ! queue.empty() )
+                return queue.front();
+        return noJob;
+    }
+
+    virtual int  quantum( int job ) const { return slice << jobs[ job ].level; }
+    virtual bool usesTimer( ) const       { return true; }
+
+    virtual void expired( int job ) {
+        if ( jobs[ job ].level + 1 < numberOfLevels )
+            jobs[ job ].level++;
+        if ( boostFactor * slice <= rmmixHardware::clock - lastBoost )
+            boost();
+    }
+
+    virtual bool preempts( int job, int current ) const {
+        return ( jobs[ job ].level < jobs[ current ].level );
+    }
+
+private:
+    std::vector< jobQueue > ready; // ready[ level ]
+    const int slice;               // quantum on the top level
+    int lastBoost = 0;             // clock tick of the last boost
+
+    // Move all jobs back to the top level (so that none starves)
+    void boost( ) {
+        for ( std::size_t job = 0; job < jobs.size(); ++job ) {
+            processControlBlock& pcb = jobs[ job ];
+            if ( ( processControlBlock::ready == pcb.state )
+                 || ( processControlBlock::notBooted == pcb.state ) ) {
+                remove( int( job ) );
+                pcb.level = 0;
+                add( int( job ) );
+            }
+            else
+                pcb.level = 0;
+        };
+        lastBoost = rmmixHardware::clock;
+    }
+}; // end mlfqPolicy
+
+// Shortest remaining time - the ready jobs are kept sorted by their
+// expected CPU burst (ties: by job number).
+class shortestRemainingTimePolicy : public rmminixOS::schedulingPolicy {
+public:
+    static const int initialEstimate = 10; // ticks
+
+    shortestRemainingTimePolicy( std::vector< processControlBlock >& table )
+    : schedulingPolicy( table ) {
+        for ( processControlBlock& pcb : jobs )
+            pcb.burstEstimate = initialEstimate;
+    };
+
+    virtual void add( int job )    { ready.insert( key( job ) ); }
+    virtual void remove( int job ) { ready.erase( key( job ) ); }
+    virtual int  next( ) const {
+        return ( ready.empty() ? noJob : ready.begin()->second );
+    }
+
+    // Exponential average (weight 1/2) of the bursts so far
+    virtual void blocked( int job, int burst ) {
+        jobs[ job ].burstEstimate = ( jobs[ job ].burstEstimate + burst ) / 2;
+    }
+
+    virtual bool preempts( int job, int current ) const {
+        const int ran = rmmixHardware::clock - jobs[ current ].dispatchTime;
+        return ( jobs[ job ].burstEstimate < jobs[ current ].burstEstimate - ran );
+    }
+
+private:
+    std::set< std::pair< int, int > > ready; // ( burstEstimate, job )
+
+    std::pair< int, int > key( int job ) const {
+        return std::make_pair( jobs[ job ].burstEstimate, job );
+    }
+}; // end shortestRemainingTimePolicy
+
+// The number after the colon in spec (e.g. "rr:10"), or otherwise if none
+int quantumIn( const std::string& spec, std::size_t nameLength, int otherwise ) {
+    if ( spec.size() == nameLength )
+        return otherwise;
+    const std::string number = spec.substr( nameLength + 1 );
+    if ( ( ':' != spec[ nameLength ] ) || number.empty()
+         || ( std::string::npos != number.find_first_not_of( "0123456789" ) )
+         || ( 6 < number.size() ) )
+        throw std::string( "Bad quantum in scheduling policy " ) + spec;
+    return std::stoi( number );
+}
+
+} // end anonymous namespace
+
+rmminixOS::schedulingPolicy* rmminixOS::makeSchedulingPolicy(
+        const std::string& spec, std::vector< processControlBlock >& jobs ) {
+    const std::string name = spec.substr( 0, spec.find( ':' ) );
+    if ( spec.empty() )
+        return new roundRobinPolicy( jobs, 0 );
+    else if ( "rr" == name )
+        return new roundRobinPolicy( jobs, quantumIn( spec, name.size(), 10 ) );
+    else if ( "priority" == spec )
+        return new priorityPolicy( jobs );
+    else if ( "mlfq" == name ) {
+        const int slice = quantumIn( spec, name.size(), 5 );
+        if ( 0 == slice )
+            throw std::string( "Bad quantum in scheduling policy " ) + spec;
+        return new mlfqPolicy( jobs, slice );
+    }
+    else if ( "srt" == spec )
+        return new shortestRemainingTimePolicy( jobs );
+    else
+        throw std::string( "Unknown scheduling policy " ) + spec;
+} // end makeSchedulingPolicy
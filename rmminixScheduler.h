@@ -0,0 +1,99 @@
+// =====================================================================
+// rmminixScheduler.h - Header file for the CPU scheduling policies of
+//                      the rmminix operating system (simulator).
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file rmminixScheduler.h
+//
+// A scheduling policy keeps the ready jobs, and decides which one gets
+// the CPU next, for how long (its quantum - the OS then programs the
+// timer, see rmmixTimerDevice), and whether a job which has just become
+// ready should take the CPU away from the running one.  The OS tells it
+// whenever a job becomes ready, stops being ready, uses up its quantum
+// or blocks (for I/O).  Built in (see makeSchedulingPolicy):
+//
+//  rr[:Q]      round robin, with a quantum of Q ticks (default 10);
+//              rr:0 runs each job until it blocks or halts - the default.
+//  priority    the job named first on the command line goes first;
+//              a job which becomes ready preempts all jobs named after it.
+//  mlfq[:Q]    multi-level feedback queue: a job which uses up its quantum
+//              moves down one level, where the quantum is twice as long
+//              (Q, 2Q, 4Q; default Q = 5).  Higher levels go first, and
+//              now and then all jobs are moved back up to the top.
+//  srt         shortest remaining time: the job with the shortest expected
+//              CPU burst (the mean of its last burst and the expected
+//              one) goes first, and preempts the running job if that one
+//              is expected to take longer.
+//
+// =====================================================================
+
+#ifndef RMMINIXSCHEDULER_H_
+#define RMMINIXSCHEDULER_H_
+
+#include <string>
+#include <vector>
+
+#include "rmminixos.h" // for processControlBlock, jobQueue
+
+namespace rmminixOS {
+
+    class schedulingPolicy {
+    public:
+        schedulingPolicy( std::vector< processControlBlock >& table )
+        : jobs( table ) { };
+
+        virtual ~schedulingPolicy( ) { };
+
+        // The ready jobs: add and remove them, and which one is next
+        // (noJob if there is none)
+        virtual void add( int job ) = 0;
+        virtual void remove( int job ) = 0;
+        virtual int  next( ) const = 0;
+
+        bool empty( ) const { return noJob == next(); }
+
+        // How many ticks job may run before the timer interrupts it
+        // (0 = no timer, i.e. until it blocks or halts)
+        virtual int quantum( int job ) const { return 0; }
+
+        // Does this policy need the timer at all?
+        virtual bool usesTimer( ) const { return false; }
+
+        // job (running) has used up its quantum
+        virtual void expired( int job ) { };
+
+        // job (running) has blocked, after running for burst ticks
+        virtual void blocked( int job, int burst ) { };
+
+        // Should job (just become ready) get the CPU from current (running)?
+        virtual bool preempts( int job, int current ) const { return false; }
+
+    protected:
+        std::vector< processControlBlock >& jobs;
+    }; // end schedulingPolicy
+
+    // Returns a new policy, as described above (e.g. "rr:10"), or throws
+    // a std::string if there is no such policy.  The empty string means rr:0.
+    schedulingPolicy* makeSchedulingPolicy( const std::string& spec,
+                                            std::vector< processControlBlock >& jobs );
+
+} // end of rmminixOS namespace
+
+#endif /* RMMINIXSCHEDULER_H_ */
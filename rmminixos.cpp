@@ -28,6 +28,7 @@
 //
 // =====================================================================
 
+#include <algorithm> // for std::max
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -41,16 +42,8 @@
 #include "rmminixos.h"
 
 #include "RMMIXJobLang.h" // for objectCodeDecompiler class
+#include "rmminixScheduler.h" // for the schedulingPolicy class
 
-#define JobFinished -3
-#define noJobLeft -1
-#define hasNotBeenBooted -2
-
-#define _trapNumber 0
-#define _trapData 1
-#define _trapStatus 2
-#define _inputData 3
-#define _regToUpdate 4
 #define _clear -1
 
 // =====================================================================
@@ -62,23 +55,61 @@
 // but we'll almost certainly need a lot more later, especially when we
 // get to multiple processes. Feel free to add whatever is necessary!
 
-objectCodeDecompiler* decompiler;
 int currentJobIndex;
-std::vector<std::vector<RMMIXinstruction>>* programmMem;
-std::vector<std::vector<int>>* registerMem;
-std::vector<char*>* argVector;
-std::vector<int>* subJobVector;
-std::vector<objectCodeDecompiler*>* obcVector;
-std::vector<std::vector<int>>* trapRegMem;
-std::vector<bool>* waitingForIOStatus;
+//one process control block per job (see rmminixos.h), never resized after boot
+std::vector<rmminixOS::processControlBlock> jobTable;
+//the jobs waiting for the cpu - the policy decides which one gets it next
+rmminixOS::schedulingPolicy* scheduler = nullptr;
+//the jobs waiting for i/o
+rmminixOS::jobQueue blockedQueue(jobTable);
 int fatalInterruptIndex = _clear;
+//how the output channels of the jobs write (see rmminixOutput.h)
+rmminixOS::outputChannel::writerType outputWriter = rmminixOS::outputChannel::bufferedWriter;
+//how many words of their input the jobs' GETWs get ahead of time
+rmminixOS::readAheadPolicy readAhead;
+//how many words of the jobs' PUTWs are collected before they are written
+rmminixOS::writeCombiningPolicy writeCombining;
+rmminixOS::writeBackStatistics writeBacks;
+
+
+// =====================================================================
+//             JOB QUEUES
+
+void rmminixOS::jobQueue::push(int job){
+	jobs[job].next = noJob;
+	jobs[job].previous = tail;
+	if(tail==noJob){
+		head = job;
+	}else{
+		jobs[tail].next = job;
+	}
+	tail = job;
+	length++;
+}
 
-//change this if possible cause is terrible and I feel bad for doing it
-std::ofstream os0;
-std::ofstream os1;
-std::ofstream os2;
-std::ofstream os3;
-std::vector<std::ofstream*>* osVector;
+int rmminixOS::jobQueue::pop(){
+	int job = head;
+	if(job!=noJob){
+		remove(job);
+	}
+	return job;
+}
+
+void rmminixOS::jobQueue::remove(int job){
+	processControlBlock& pcb = jobs[job];
+	if(pcb.previous==noJob){
+		head = pcb.next;
+	}else{
+		jobs[pcb.previous].next = pcb.next;
+	}
+	if(pcb.next==noJob){
+		tail = pcb.previous;
+	}else{
+		jobs[pcb.next].previous = pcb.previous;
+	}
+	pcb.next = pcb.previous = noJob;
+	length--;
+}
 
 
 
@@ -94,6 +125,15 @@ std::vector<std::ofstream*>* osVector;
 
 void rmminixOS::handleHALT( )
 {
+    //a job halts only once all its asynchronous requests are done, and
+    //everything it has written is written
+    writeBack(currentJobIndex);
+    if(jobTable[currentJobIndex].asyncInFlight||jobTable[currentJobIndex].wordsWritingBack){
+	waitForCompletion(currentJobIndex);
+	return;
+    }
+    //but the words it read ahead are of no use to its next subjob
+    cancelIO(currentJobIndex);
 
     int status = theCPU->registers[ theCPU->trapData ];
     rmmixHardware::logStream << "Simulation Halt! Status = ";
@@ -104,12 +144,10 @@ void rmminixOS::handleHALT( )
 	return;
     }else{
 //check if another job is there but cannot be switched into cause the job is waiting for io operations
-	for(int i=0;i<waitingForIOStatus->size();i++){
-		if(!waitingForIOStatus->at(i)){
-			theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
-			theCPU->registers[0]=-1;
-			return;
-		}
+	if(!blockedQueue.empty()){
+		theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+		idleCPU();
+		return;
 	}
 exit(status);
 }
@@ -131,6 +169,8 @@ void rmminixOS::handleFATAL()
 theCPU->trapNumber=0;
     //reset the index
     fatalInterruptIndex=_clear;
+    //the crashed job's requests are of no use to anyone any more
+    cancelIO(jobIndex);
     rmmixHardware::logStream << "FATAL Interrupt!!" << std::endl;
     std::cerr << "FATAL Interrupt!!" << std::endl;
     // This is OK if we only want to run one program -
@@ -141,22 +181,22 @@ theCPU->trapNumber=0;
     }else{
 
 	//current programm failed so we have to mark is as finished
-	setPCof(jobIndex,JobFinished);
+	finishJob(jobIndex);
 
 
 		if(switchProgramm()){
 		
 		return;
 		}else{
+			//if the failed job was not the current one (i/o failed), the current one goes on
+			if(jobTable[currentJobIndex].state==processControlBlock::running){
+				return;
+			}
 			//check if another job is there but cannot be switched into cause the job is waiting for io operations
-	for(int i=0;i<waitingForIOStatus->size();i++){
-		if(!waitingForIOStatus->at(i)){
-			
-			theCPU->registers[0]=-1;
-			
-			return;
-		}
-	}
+			if(!blockedQueue.empty()){
+				idleCPU();
+				return;
+			}
 			  exit( theCPU->trapData );
 		}
    
@@ -164,9 +204,25 @@ theCPU->trapNumber=0;
     
 } // end handleFATAL
 
+// =====================================================================
+//       Timer - the current job's time slice (quantum) is over
+
+void rmminixOS::handleTIMER()
+{
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+	//the timer is stopped while the cpu is idle, but just in case...
+	if(theCPU->registers[0]<0||jobTable[currentJobIndex].state!=processControlBlock::running){
+		return;
+	}
+	scheduler->expired(currentJobIndex);
+	//let the next job run, if the policy says so (else, a new quantum)
+	switchProgramm();
+
+} // end handleTIMER
+
 bool rmminixOS::isCurrentJobDone(){
 //check if the pc is at the last instruction of the current Programm	
-	if(theCPU->registers[ 0 ]==programmMem->at(currentJobIndex).size()){
+	if(theCPU->registers[ 0 ]==int(jobTable[currentJobIndex].program.size())){
 		return true;
 	}else{
 		return false;
@@ -175,13 +231,8 @@ bool rmminixOS::isCurrentJobDone(){
 }
 
 void rmminixOS::removeCurrentJob(){
-	//close the old os stream
-	assert( hardwareComponents[(currentJobIndex+1)*2] ); // is not null
-	
-	//close the file in which the ostream is writing, change this line if something more readable is possible
-	//osVector->at(currentJobIndex)->close();
-        	
-	setPCof(currentJobIndex,JobFinished);
+	//finishing the job also closes its files (see releaseJobIO)
+	finishJob(currentJobIndex);
 
 }
 
@@ -190,105 +241,188 @@ bool rmminixOS::switchProgramm(){
 		removeCurrentJob();
 	}
 
-	//check if another job is waiting
-	int nextJobIndex = getNextWaitingJob();
-	
-       	if(nextJobIndex!=noJobLeft&&nextJobIndex!=currentJobIndex){
-		executeJobChange(nextJobIndex,false);
-		return true;
-	}else{
-		return false;
+	//if the current job could go on, it is ready like all the others -
+	//the scheduling policy decides if it may (e.g. round robin: only if
+	//no other job is waiting)
+	processControlBlock& currentJob = jobTable[currentJobIndex];
+	if(currentJob.state==processControlBlock::running){
+		currentJob.state = processControlBlock::ready;
+		scheduler->add(currentJobIndex);
 	}
 
+	//check if another job is waiting - jobs which cannot be booted are
+	//finished, so try the next one
+	for(int nextJobIndex=getNextWaitingJob();nextJobIndex!=noJob;nextJobIndex=getNextWaitingJob()){
+		if(nextJobIndex==currentJobIndex){
+			scheduler->remove(currentJobIndex);
+			currentJob.state = processControlBlock::running;
+			startQuantum(currentJobIndex);
+			return false;
+		}
+		if(executeJobChange(nextJobIndex,false)){
+			return true;
+		}
+	}
+	return false;
+
 }
 
 void rmminixOS::restoreRegState(int nextJobIndex){
-	for(int i=0;i<registerMem->at(0).size();i++){
-		theCPU->registers.at(i)=registerMem->at(nextJobIndex).at(i);
-		
-		
-	}
+	//no copying - the cpu just switches to the register bank of the next job
+	theCPU->registers = jobTable[nextJobIndex].registers.data();
 restoreTrapRegs(nextJobIndex);
 
 }
 
 
 
-void rmminixOS::executeJobChange(int nextJobIndex,bool afterIdle){
-	//check if the next job is the current Job, in that case nothing has to be done	
+bool rmminixOS::executeJobChange(int nextJobIndex,bool afterIdle){
+	processControlBlock& nextJob = jobTable[nextJobIndex];
+	//boot the next job first, if it has never run - if that fails, it's finished
+	if(nextJob.state==processControlBlock::notBooted&&!bootProgramm(nextJobIndex)){
+		finishJob(nextJobIndex);
+		return false;
+	}
+	scheduler->remove(nextJobIndex);
+
 	//dont save the registers if the currentJob is done or this function was called afer
 	//the cpu was idle, in that case the pc is -1 and we dont want to save that ofc
 	//the register have been saves before the cpu was set to idle
-	if(getPCof(currentJobIndex)!=JobFinished&& (!afterIdle)){
+	processControlBlock& currentJob = jobTable[currentJobIndex];
+	if(currentJob.state!=processControlBlock::finished&& (!afterIdle)){
 	
 	saveRegisters();
 	}
+	//a job that still could run has to wait for the cpu again
+	if(currentJob.state==processControlBlock::running){
+		currentJob.state = processControlBlock::ready;
+		scheduler->add(currentJobIndex);
+	}
 
 	restoreRegState(nextJobIndex);
-	//hardwareComponents[0]->trapNumber=0;
-	
-	//check if the next job has been booted
-	if(hasBeenBooted(nextJobIndex)){
-		bootProgramm(nextJobIndex);
-		
-		
-	}else{
-		
-		restoreInstructionMem(nextJobIndex);
-		currentJobIndex=nextJobIndex;
-		
-	
+	restoreInstructionMem(nextJobIndex);
+	currentJobIndex=nextJobIndex;
+	nextJob.state = processControlBlock::running;
+	startQuantum(nextJobIndex);
+	return true;
+}
+
+void rmminixOS::startQuantum(int jobIndex){
+	jobTable[jobIndex].dispatchTime = rmmixHardware::clock;
+	rmmixTimerDevice* timer = hardwareComponents.timer();
+	if(timer){
+		timer->trapNumber = RMMIX_JDL::TIMER;
+		timer->trapData = scheduler->quantum(jobIndex);
 	}
 }
 
-void rmminixOS::clearInterrupts(int jobIndex){
-trapRegMem->at(jobIndex).at(_trapNumber) = 0;
-trapRegMem->at(jobIndex).at(_trapData) = 0;
-trapRegMem->at(jobIndex).at(_trapStatus) = 0;
+void rmminixOS::idleCPU(){
+	//no job runs, so no job's time slice can be over
+	rmmixTimerDevice* timer = hardwareComponents.timer();
+	if(timer){
+		timer->trapNumber = RMMIX_JDL::TIMER;
+		timer->trapData = 0;
+	}
+	theCPU->idle();
+}
 
+void rmminixOS::blockJob(int jobIndex){
+	scheduler->blocked(jobIndex,rmmixHardware::clock-jobTable[jobIndex].dispatchTime);
+	jobTable[jobIndex].state = processControlBlock::blocked;
+	blockedQueue.push(jobIndex);
 }
 
-void rmminixOS::restoreInstructionMem(int nextJobIndex){
-	theCPU->instructionMemory.clear();
-	for(int i = 0;i<programmMem->at(nextJobIndex).size();i++){
-		theCPU->instructionMemory[i] = programmMem->at(nextJobIndex).at(i);
+void rmminixOS::unblockJob(int jobIndex){
+	//a job can be finished while its i/o is still going on (FATAL, or
+	//its last instruction was the GETW or PUTW) - then it stays finished
+	if(jobTable[jobIndex].state==processControlBlock::blocked){
+		blockedQueue.remove(jobIndex);
+		jobTable[jobIndex].state = processControlBlock::ready;
+		scheduler->add(jobIndex);
 	}
 }
 
-bool rmminixOS::hasBeenBooted(int nextJob){
-	if(getPCof(nextJob)==hasNotBeenBooted){
-		return true;
-	}else{
-		return false;
+void rmminixOS::preemptFor(int jobIndex){
+	//only a running job can be preempted, and only by a ready one
+	if(theCPU->registers[0]>=0&&jobTable[jobIndex].state==processControlBlock::ready&&
+	   jobTable[currentJobIndex].state==processControlBlock::running&&
+	   scheduler->preempts(jobIndex,currentJobIndex)){
+		switchProgramm();
 	}
+}
 
+void rmminixOS::finishJob(int jobIndex){
+	dequeueJob(jobIndex);
+	jobTable[jobIndex].state = processControlBlock::finished;
+	//a job which just ran out of instructions has not written everything yet
+	writeBack(jobIndex);
+	releaseJobIO(jobIndex);
 }
 
-void rmminixOS::saveRegisters(){
-	for(int i=0;i<registerMem->at(0).size();i++){ 
-		registerMem->at(currentJobIndex).at(i)= theCPU->registers.at(i);
+void rmminixOS::releaseJobIO(int jobIndex){
+	processControlBlock& job = jobTable[jobIndex];
+	rmmixInputDevice& input = hardwareComponents.inputs[jobIndex];
+	rmmixOutputDevice& output = hardwareComponents.outputs[jobIndex];
+	//a job whose last instruction was a GETW or PUTW is finished before
+	//its i/o is - then its files are released when the device is done
+	rmmixDMADevice* dma = hardwareComponents.dma();
+	if(job.state!=processControlBlock::finished||!job.io||
+	   !job.inputRequests.empty()||!job.outputRequests.empty()||
+	   input.busy()||output.busy()||(dma&&dma->busy(jobIndex))){
+		return;
 	}
-saveTrapRegs();
+	input.decompiler = nullptr;
+	output.outputSink = nullptr;
+	closeOutput(jobIndex);
+	job.io.reset();
+}
 
+void rmminixOS::closeOutput(int jobIndex){
+	processControlBlock& job = jobTable[jobIndex];
+	//only now is everything the subjob has written in its file
+	if(job.io&&!job.io->output.close()){
+		std::cerr << "Could not write output file "
+		          << getOutputFilename(jobIndex) << std::endl;
+	}
 }
 
-int rmminixOS::getNextWaitingJob(){
-	//check the entire list
+void rmminixOS::dequeueJob(int jobIndex){
+	switch(jobTable[jobIndex].state){
+	case processControlBlock::notBooted:
+	case processControlBlock::ready:
+		scheduler->remove(jobIndex);
+		break;
+	case processControlBlock::blocked:
+		blockedQueue.remove(jobIndex);
+		break;
+	default: // running and finished jobs are in no queue
+		break;
+	}
+}
 
-	for(int i=0;i<registerMem->size();i++){
-		if(getPCof((currentJobIndex+1+i)%registerMem->size())!=JobFinished){
-			if(waitingForIOStatus->at((currentJobIndex+1+i)%registerMem->size())){
-					return (currentJobIndex+1+i)%registerMem->size();
-				}
-		}		
+void rmminixOS::clearInterrupts(int jobIndex){
+jobTable[jobIndex].trapNumber = 0;
+jobTable[jobIndex].trapData = 0;
+jobTable[jobIndex].trapStatus = 0;
 
-		//if(getPCof((currentJobIndex+1+i)%registerMem->size())!=JobFinished&&waitingForIOStatus->at((currentJobIndex+1+i)%registerMem->size())){
-						
-		//	return (currentJobIndex+1+i)%registerMem->size();
-		//}
-	}
-	
-	return noJobLeft;
+}
+
+void rmminixOS::restoreInstructionMem(int nextJobIndex){
+	//no copying either - the cpu just switches to the code segment of the next job
+	theCPU->instructionMemory = &jobTable[nextJobIndex].program;
+	theCPU->decodedMemory = &jobTable[nextJobIndex].decoded;
+}
+
+void rmminixOS::saveRegisters(){
+	//nothing to do for the registers themselves - the cpu works in the
+	//register bank of the current job (see restoreRegState)
+saveTrapRegs();
+
+}
+
+int rmminixOS::getNextWaitingJob(){
+	//no need to check the entire list - the scheduling policy knows
+	return scheduler->next();
 }
 
 
@@ -297,24 +431,24 @@ std::string rmminixOS::getOutputFilename(int jobIndex){
 	std::string filename = "Mainjob";
 	filename.append(std::to_string(jobIndex));
         filename.append("Subjob");
-        filename.append(std::to_string(subJobVector->at(currentJobIndex)));
+        filename.append(std::to_string(jobTable[jobIndex].subJob));
 	filename.append(".txt");	
 	return filename;
 
 }
 
 void rmminixOS::restoreTrapRegs(int nextJobIndex){
-theCPU->trapNumber = trapRegMem->at(nextJobIndex).at(_trapNumber);
-theCPU->trapData = trapRegMem->at(nextJobIndex).at(_trapData); 
-theCPU->trapStatus = trapRegMem->at(nextJobIndex).at(_trapStatus);
+theCPU->trapNumber = jobTable[nextJobIndex].trapNumber;
+theCPU->trapData = jobTable[nextJobIndex].trapData; 
+theCPU->trapStatus = jobTable[nextJobIndex].trapStatus;
 
 
 }
 
 void rmminixOS::saveTrapRegs(){
-trapRegMem->at(currentJobIndex).at(_trapNumber) = theCPU->trapNumber;
-trapRegMem->at(currentJobIndex).at(_trapData) = theCPU->trapData;
-trapRegMem->at(currentJobIndex).at(_trapStatus) = theCPU->trapStatus;
+jobTable[currentJobIndex].trapNumber = theCPU->trapNumber;
+jobTable[currentJobIndex].trapData = theCPU->trapData;
+jobTable[currentJobIndex].trapStatus = theCPU->trapStatus;
 
 }
 
@@ -323,7 +457,8 @@ void rmminixOS::storeInput(int input,int inputDeviceNumber){
 //calculate the job index depending on the input device
 int jobIndex = inputToJobIndex(inputDeviceNumber);
 
-registerMem->at(jobIndex)[trapRegMem->at(jobIndex)[_regToUpdate]] = input;
+processControlBlock& job = jobTable[jobIndex];
+job.registers[job.regToUpdate] = input;
 
 
 }
@@ -340,19 +475,25 @@ return (deviceNumber/2)-1;
 
 bool rmminixOS::loadNextProgramm(int jobIndex){
 
-	//close the old os stream
 	assert( hardwareComponents[(jobIndex+1)*2] ); // is not null
     
 	//try loading another programm	
 	//check for another job line
-	if(obcVector->at(jobIndex)->gotoState( JobLangCompiler::codeReaderState  )){
+	processControlBlock& job = jobTable[jobIndex];
+	//a finished job stays finished (e.g. if its last GETW failed)
+	if(job.state==processControlBlock::finished){
+		return false;
+	}
+	//close the old os stream
+	closeOutput(jobIndex);
+	if(job.io->decompiler.gotoState( JobLangCompiler::codeReaderState  )){
 			
-		if(!rmminixOS::load(*(obcVector->at(jobIndex)),jobIndex)){
+		if(!rmminixOS::load(job.io->decompiler,jobIndex)){
 		
 		return false;		
 		}
 		
-		subJobVector->at(jobIndex)=subJobVector->at(jobIndex)+1;
+		job.subJob++;
 		
 		
 		//OPEN A NEW OS STREAM
@@ -361,9 +502,9 @@ bool rmminixOS::loadNextProgramm(int jobIndex){
 
 		//rebind io components
  		assert( hardwareComponents[ ((jobIndex+1)*2)-1 ] ); // is not null
-        	hardwareComponents[((jobIndex+1)*2)-1 ]->bind( (obcVector->at(jobIndex)) );
+        	hardwareComponents[((jobIndex+1)*2)-1 ]->bind( &job.io->decompiler );
     		assert( hardwareComponents[(jobIndex+1)*2] ); // is not null
-                hardwareComponents[(jobIndex+1)*2 ]->bind( (osVector->at(jobIndex)) ); // bind to std out
+                hardwareComponents[(jobIndex+1)*2 ]->bind( &job.io->output );
 		//trap number fuer neustart auf initzialwert setzten		
 		hardwareComponents[0]->trapNumber=0;
 
@@ -397,28 +538,35 @@ bool rmminixOS::load( objectCodeDecompiler& decompiler,int programmIndex )
     else try // if ready to read object code (i.e. $JOB found)
     {
         RMMIXinstruction instruction;
-        int instructionNumber = 0;
+	processControlBlock& job = jobTable[programmIndex];
 	bool loadingForCurrentJob= programmIndex==currentJobIndex;
-	programmMem->at(programmIndex).clear();
+	job.program.clear();
         // Parses each line after $JOB to $RUN
         while ( decompiler >> instruction ) {
-	if(loadingForCurrentJob){
-	theCPU->instructionMemory[ instructionNumber ] = instruction;
-	}    
-        ++instructionNumber;
-	programmMem->at(programmIndex).push_back(instruction);
+	job.program.push_back(instruction);
 
         }; // until no more lines or found $RUN
-	if(loadingForCurrentJob){
+	// verify the program once, here - only the instructions which
+	// fail are checked as they run (see rmmixCPU::verify)
+	job.program.unverified = theCPU->verify(job.program);
+	// translate the program once, here, for the threadedEngine
+	job.decoded.decode(job.program);
+	// and find its native code, if it was compiled by rmmixaot
+	if(theCPU->aotJobs){
+	job.decoded.aotCode = theCPU->aotJobs->lookup(job.program);
+	}
 	// if we're here, then we could load the program.
-        theCPU->registers[ 0 ] = 0;
+	job.registers[ 0 ] = 0;
+	job.ringEntries = 0; // no asynchronous i/o (yet)
+	if(loadingForCurrentJob){
+	//the current job keeps (or, after a FATAL while the cpu was idle, gets) the cpu
+	dequeueJob(programmIndex);
+	job.state = processControlBlock::running;
+	startQuantum(programmIndex);
+	theCPU->registers = job.registers.data();
+	theCPU->instructionMemory = &job.program;
+	theCPU->decodedMemory = &job.decoded;
 	}
-	setPCof(programmIndex,0);    
-        
-	
-
-	
-	
 
         return true;
     } catch ( std::string error  ) { // if an exception was thrown, something went wrong.
@@ -429,22 +577,22 @@ bool rmminixOS::load( objectCodeDecompiler& decompiler,int programmIndex )
 } // end load
 
 
+//boots a job: opens its object file, loads the first $JOB and binds the
+//i/o devices - but leaves the cpu alone, unless it is the current job
+//(see load and executeJobChange)
 bool rmminixOS::bootProgramm(int programmIndex){
   
-    theCPU->instructionMemory.clear();
- 
-    int tempCurrentJobIndex = currentJobIndex;
+    processControlBlock& job = jobTable[programmIndex];
     // SET UP INPUT
-    // try to open a decompiler with a given file name
-    decompiler = new objectCodeDecompiler(argVector->at(programmIndex));
-    // We call new instead of using a local variable so that the
-    // decompiler object survives the call to this function
-     // (it will be used later by the intput device object).
+    // try to open a decompiler with a given file name - it lives in the
+    // job's I/O context, which survives the call to this function
+    // (it will be used later by the intput device object).
+    job.io.reset( new jobIOContext( job.filename, outputWriter ) );
+    objectCodeDecompiler* decompiler = &job.io->decompiler;
 
     // Basic error checking (argv arguments are often bad, so be careful)
-    assert( decompiler ); // is not null
     if ( ! decompiler->good() ) {
-        std::cerr << "Could not open object file with name "  << argVector->at(programmIndex)
+        std::cerr << "Could not open object file with name "  << job.filename
                   << std::endl;
         return false;
     };
@@ -453,88 +601,104 @@ bool rmminixOS::bootProgramm(int programmIndex){
                  << " appears to be empty."   << std::endl;
         return false;
     };
-	currentJobIndex=programmIndex;
     // Load the instruction memory
     if ( ! rmminixOS::load( *decompiler,programmIndex )) {
-        std::cerr << "BOOT LOAD FAILED - File name " << argVector->at(programmIndex) << std::endl;
-	currentJobIndex = tempCurrentJobIndex;
+        std::cerr << "BOOT LOAD FAILED - File name " << job.filename << std::endl;
 	 return false;
     } else { // if load was successful
 
         assert( decompiler->good() ); // should still be OK
         assert( ! decompiler->eof() ); // should not be at eof (or can it?)
-        obcVector->push_back(decompiler);
 
 
         assert( hardwareComponents[ ((programmIndex+1)*2)-1 ] ); // is not null
-        hardwareComponents[((programmIndex+1)*2)-1]->bind( obcVector->back() );
+        hardwareComponents[((programmIndex+1)*2)-1]->bind( decompiler );
 
     }; // end if load successful
 
     // SET UP OUTPUT
     assert( hardwareComponents[(programmIndex+1)*2] ); // is not null
     
-   
-   
-
-    //hardwareComponents[((programmIndex+1)*2)]->bind( (osVector->at(currentJobIndex)) ); // bind to std out
-hardwareComponents[((programmIndex+1)*2)]->bind(osVector->at(currentJobIndex));
-    setPCof(programmIndex,0);
+hardwareComponents[((programmIndex+1)*2)]->bind(&job.io->output);
     
 return true;
 }
 
-void rmminixOS::setPCof(int programmIndex,int newPC){
-registerMem->at(programmIndex).at(0)=newPC;
-return;
-}
+namespace {
 
-int rmminixOS::getPCof(int programmIndex){
-return registerMem->at(programmIndex).at(0);
+// A number in a read-ahead or write-combining policy (see rmminixos.h)
+int wordsIn( const std::string& number, const std::string& spec, const char* policy ) {
+    if ( number.empty()
+         || ( std::string::npos != number.find_first_not_of( "0123456789" ) )
+         || ( 6 < number.size() ) )
+        throw std::string( "Bad " ) + policy + " policy " + spec;
+    return std::stoi( number );
+}
 
+} // end anonymous namespace
+
+rmminixOS::readAheadPolicy rmminixOS::makeReadAheadPolicy( const std::string& spec ) {
+    readAheadPolicy policy;
+    if ( spec.empty() )
+        return policy;
+    const std::size_t colon = spec.find( ':' );
+    policy.depth = wordsIn( spec.substr( 0, colon ), spec, "read-ahead" );
+    policy.burst = ( std::string::npos == colon )
+                   ? ( policy.depth + 1 ) / 2
+                   : wordsIn( spec.substr( colon + 1 ), spec, "read-ahead" );
+    if ( ( 0 == policy.depth ) ? ( 0 != policy.burst )
+                               : ( ( policy.burst < 1 ) || ( policy.depth < policy.burst ) ) )
+        throw std::string( "Bad read-ahead policy " ) + spec;
+    return policy;
+} // end makeReadAheadPolicy
+
+rmminixOS::writeCombiningPolicy rmminixOS::makeWriteCombiningPolicy( const std::string& spec ) {
+    writeCombiningPolicy policy;
+    if ( spec.empty() )
+        return policy;
+    const std::size_t colon = spec.find( ':' );
+    policy.size  = wordsIn( spec.substr( 0, colon ), spec, "write-combining" );
+    policy.limit = ( std::string::npos == colon )
+                   ? 2 * policy.size
+                   : wordsIn( spec.substr( colon + 1 ), spec, "write-combining" );
+    if ( ( 0 == policy.size ) ? ( 0 != policy.limit ) : ( policy.limit < policy.size ) )
+        throw std::string( "Bad write-combining policy " ) + spec;
+    return policy;
+} // end makeWriteCombiningPolicy
+
+const rmminixOS::writeBackStatistics& rmminixOS::writeBackStats( ) {
+    return writeBacks;
 }
+
 // =====================================================================
 //           Boot -
-//     Construct a decompiler, and bind it to the input device.
-//     Bind standard out to the output device.
+//     Set up one process control block per job (all ready to run, in
+//     the order given) and the scheduling policy (and the timer, if it
+//     needs one), then boot the first job and give it the CPU.
 //     This will have to be changed when we go to multiple I/O devices...
 //     Returns true if and only if everything booted OK
-bool rmminixOS::boot(int argc,char *argv[]) {
+bool rmminixOS::boot(int argc,char *argv[],const std::string& schedulingPolicy,
+                     outputChannel::writerType writer,const std::string& readAheadPolicy,
+                     const std::string& writeCombiningPolicy) {
         currentJobIndex = 0;
-       
 
-	programmMem = new std::vector<std::vector<RMMIXinstruction>>();
-	argVector = new std::vector<char*>();
-	registerMem = new std::vector<std::vector<int>>();
-	subJobVector = new std::vector<int>(5,0);
-	obcVector = new std::vector<objectCodeDecompiler*>();
-	trapRegMem = new std::vector<std::vector<int>>();
-	waitingForIOStatus = new std::vector<bool>();
-	
-	//this should be changed if a better solution pops up
-	//put atm i can think of anything else
-	//Problem: ofstream's dont have copy constructor that are needed by the vector
-	//and vec->push_back(std::ofstream()) or without () doesnt work       	
-		
-	osVector = new std::vector<std::ofstream*>();
-	osVector->push_back(&os0);
-	osVector->push_back(&os1);
-	osVector->push_back(&os2);
-	osVector->push_back(&os3);
-	
-	
+	//Note: where in argc the first programm has the index 1, in jobTable it will be 0	
+	jobTable = std::vector<processControlBlock>(argc-1);
 	for(int i=0;i<argc-1;i++){
-        programmMem->push_back(std::vector<RMMIXinstruction>());
-	//Note: where in argc the first programm has the index 1, in argVector it will be 0	
-	trapRegMem->push_back(std::vector<int>(4,0));
-	argVector->push_back(argv[i+1]);
-	registerMem->push_back(std::vector<int>(32,0));
-	waitingForIOStatus->push_back(true);
-	setPCof(i,hasNotBeenBooted);
-
-	
+	jobTable[i].filename = argv[i+1];
         }
- 
+	outputWriter = writer;
+	readAhead = makeReadAheadPolicy(readAheadPolicy);
+	writeCombining = makeWriteCombiningPolicy(writeCombiningPolicy);
+	scheduler = makeSchedulingPolicy(schedulingPolicy,jobTable);
+	for(int i=0;i<argc-1;i++){
+	scheduler->add(i);
+        }
+	if(scheduler->usesTimer()){
+		hardwareComponents.addTimer();
+	}
+	
+	//job 0 is the current job, so loading it gives it the cpu
 	return bootProgramm(0);
       
 } // end boot
@@ -553,11 +717,18 @@ void rmminixOS::handleGETW(  )
 	int tempJobIndex = currentJobIndex;	
 	
     assert( theCPU ); // i.e. assert that theCPU is not a null pointer
-    // Save data we will need later
+    //with read-ahead, the word may be there already
+    if(0<readAhead.depth){
+	getWordReadAhead();
+	return;
+    }
+    // Save data we will need later (the request first - switching may
+    // finish the job, see releaseJobIO)
+    jobTable[tempJobIndex].inputRequests.push_back(ioRequest());
     if ( 0 <= theCPU->registers[0] ) {
      //save the register into which 		
-    trapRegMem->at(currentJobIndex)[_regToUpdate] = theCPU->trapData;	
-    waitingForIOStatus->at(currentJobIndex) = false;
+    jobTable[currentJobIndex].regToUpdate = theCPU->trapData;	
+    blockJob(currentJobIndex);
     //try to switch to another job, if no other job
      
      if(!switchProgramm()){
@@ -566,7 +737,7 @@ void rmminixOS::handleGETW(  )
 	//save the registers...mainly for the pc
 	saveRegisters();
 	
-        theCPU->registers[ 0 ] = -1; // make the cpu wait!
+        idleCPU(); // make the cpu wait!
 	
      }
     
@@ -593,6 +764,50 @@ void rmminixOS::handleGETW(  )
 
 } // end handleGETW
 
+void rmminixOS::getWordReadAhead( )
+{
+	int jobIndex = currentJobIndex;
+	processControlBlock& job = jobTable[jobIndex];
+	job.regToUpdate = theCPU->trapData;
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+	//no need to wait
+	if(!job.readAhead.empty()){
+		job.registers[job.regToUpdate] = job.readAhead.front();
+		job.readAhead.pop_front();
+		readAheadFor(jobIndex);
+		finishIfDone();
+		return;
+	}
+	//no word will come - same as a GETW which fails (see handleGETW_READY)
+	if(job.endOfInput){
+		theCPU->trapNumber = RMMIX_JDL::FATAL;
+		theCPU->trapData = ((jobIndex+1)*2)-1;
+		return;
+	}
+	//wait for the next burst (see handleGETW_READY)
+	job.waitingForInput = true;
+	readAheadFor(jobIndex);
+	blockJob(jobIndex);
+	if(!switchProgramm()){
+		saveRegisters();
+		idleCPU(); // make the cpu wait!
+	}
+} // end getWordReadAhead
+
+void rmminixOS::readAheadFor(int jobIndex){
+	processControlBlock& job = jobTable[jobIndex];
+	//one burst at a time - so the device reads no further than the input goes
+	if(job.state==processControlBlock::finished||job.readAheadInFlight||job.endOfInput||
+	   readAhead.depth-int(job.readAhead.size())<readAhead.burst){
+		return;
+	}
+	job.readAheadInFlight = readAhead.burst;
+	ioRequest request;
+	request.readAhead = true;
+	job.inputRequests.push_back(request);
+	hardwareComponents.inputs[jobIndex].queued.push_back(job.readAheadInFlight);
+}
+
 // Input, Phase 2 (Device signals completion)
 void rmminixOS::handleGETW_READY( )
 {
@@ -601,11 +816,46 @@ void rmminixOS::handleGETW_READY( )
 	
     assert( theCPU ); // i.e. assert that theCPU is not a null pointer
  int inputDevice = theCPU->trapData;
+	// which request is done - they complete in the order they were made
+	processControlBlock& job = jobTable[inputToJobIndex(inputDevice)];
+	rmmixInputDevice& device = hardwareComponents.inputs[inputToJobIndex(inputDevice)];
+	assert( !job.inputRequests.empty() && !device.received.empty() );
+	ioRequest request = job.inputRequests.front();
+	job.inputRequests.pop_front();
+	std::vector<int> words = device.received.front();
+	device.received.pop_front();
+	int input = words.empty() ? 0 : words.front();
+	int status = theCPU->trapStatus;
+	if(request.async){
+		completeAsyncRequest(inputToJobIndex(inputDevice),request,status,true,input);
+		return;
+	}
+	if(request.readAhead){
+		//a short burst: the input is used up
+		job.endOfInput = int(words.size())<job.readAheadInFlight;
+		job.readAheadInFlight = 0;
+		job.readAhead.insert(job.readAhead.end(),words.begin(),words.end());
+		if(!job.waitingForInput){
+			theCPU->trapData=theCPU->trapStatus=theCPU->trapNumber=0;
+			readAheadFor(inputToJobIndex(inputDevice));
+			//if the job is finished already, its files are no longer needed
+			releaseJobIO(inputToJobIndex(inputDevice));
+			return;
+		}
+		//the job waits for the first of the words - as if it had read it itself
+		job.waitingForInput = false;
+		status = job.readAhead.empty();
+		if(!status){
+			input = job.readAhead.front();
+			job.readAhead.pop_front();
+			readAheadFor(inputToJobIndex(inputDevice));
+		}
+	}
     // The hardware has signaled that the get-word operation is done.
-    if ( 0 != theCPU->trapStatus ) {
+    if ( 0 != status ) {
         // trigger fatal interrupt (crash current process)
 	hardwareComponents[ inputDevice ]->trapData = hardwareComponents[ inputDevice ]->trapStatus = hardwareComponents[ inputDevice ]->trapNumber = 0;
-	waitingForIOStatus->at(inputToJobIndex(inputDevice))=true;
+	unblockJob(inputToJobIndex(inputDevice));
 	theCPU->trapNumber = RMMIX_JDL::FATAL;
 	fatalInterruptIndex = inputToJobIndex(inputDevice); //the os needs to know wich job caused the fatal interrupt
     } else { // if OK status
@@ -615,40 +865,55 @@ void rmminixOS::handleGETW_READY( )
         assert( hardwareComponents[ inputDevice ] ); // not null
 	
         // Get data from input device
-	storeInput(hardwareComponents[ inputDevice ]->trapData,inputDevice);
+	storeInput(input,inputDevice);
 	
 	clearInterrupts(inputToJobIndex(inputDevice));
 	
 	theCPU->trapData=theCPU->trapStatus=theCPU->trapNumber=0;
 	hardwareComponents[ inputDevice ]->trapData = hardwareComponents[ inputDevice ]->trapStatus = hardwareComponents[ inputDevice ]->trapNumber = 0;
 	
-	waitingForIOStatus->at(inputToJobIndex(inputDevice))=true;
+	unblockJob(inputToJobIndex(inputDevice));
 	//check if the cpu was ideling cause no other job was there
-        if(theCPU->registers[0]== -1){
-		executeJobChange(inputToJobIndex(inputDevice),true);
+        if(theCPU->registers[0]== -1&&!scheduler->empty()){
+		executeJobChange(getNextWaitingJob(),true);
 	
 	
+	}else{
+		//or should the job get the cpu right away?
+		preemptFor(inputToJobIndex(inputDevice));
 	}
+	//if the job is finished already, its files are no longer needed
+	releaseJobIO(inputToJobIndex(inputDevice));
     };
 } // end handleGETW_READY
 
 // Output, Phase 1 (CPU requests output)
 void rmminixOS::handlePUTW( )
 {
-
-osVector->at(currentJobIndex)->open(getOutputFilename(currentJobIndex));
+	//the subjob's output file is opened by its first PUTW, and stays open
+	//until it halts (see closeOutput)
+	if(!jobTable[currentJobIndex].io->output.is_open()){
+		jobTable[currentJobIndex].io->output.open(getOutputFilename(currentJobIndex));
+	}
+	//with write-combining, the job need not wait for the device
+	if(0<writeCombining.size){
+		putWordCombined();
+		return;
+	}
 
 	int tempJobIndex=currentJobIndex;
 	int tempTrapData = theCPU->registers[ theCPU->trapData ];
     assert( theCPU ); // i.e. assert that theCPU is not a null pointer
-    // Save data we will need later
+    // Save data we will need later (the request first - switching may
+    // finish the job, see releaseJobIO)
+    jobTable[tempJobIndex].outputRequests.push_back(ioRequest());
     if ( 0 <= theCPU->registers[0] ) {
-        waitingForIOStatus->at(currentJobIndex) = false;
+        blockJob(currentJobIndex);
     //try to switch to another job, if no other job
      if(!switchProgramm()){
 	// Put the CPU in an idle state until PUTW_READY signal
 	saveRegisters();
-        theCPU->registers[ 0 ] = -1; // make the cpu wait!
+        idleCPU(); // make the cpu wait!
 	
      }
        
@@ -675,6 +940,50 @@ osVector->at(currentJobIndex)->open(getOutputFilename(currentJobIndex));
 
 } // end handlePUTW
 
+void rmminixOS::putWordCombined( )
+{
+	int jobIndex = currentJobIndex;
+	processControlBlock& job = jobTable[jobIndex];
+	//no room - wait until a block has been written back
+	if(int(job.writeBuffer.size())+job.wordsWritingBack>=writeCombining.limit){
+		waitForCompletion(jobIndex);
+		return;
+	}
+	if(job.writeBuffer.empty()){
+		job.writeBufferSince = rmmixHardware::clock;
+	}
+	job.writeBuffer.push_back(theCPU->registers[theCPU->trapData]);
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+	if(int(job.writeBuffer.size())>=writeCombining.size){
+		writeBack(jobIndex);
+	}
+	finishIfDone();
+} // end putWordCombined
+
+void rmminixOS::finishIfDone(){
+	//a job whose last instruction was a GETW or PUTW is finished - even if
+	//it did not have to wait
+	if(isCurrentJobDone()&&!switchProgramm()){
+		saveRegisters();
+		idleCPU(); // make the cpu wait!
+	}
+}
+
+void rmminixOS::writeBack(int jobIndex){
+	processControlBlock& job = jobTable[jobIndex];
+	if(job.writeBuffer.empty()){
+		return;
+	}
+	ioRequest request;
+	request.writeBack = true;
+	request.words = int(job.writeBuffer.size());
+	request.issued = job.writeBufferSince;
+	job.outputRequests.push_back(request);
+	job.wordsWritingBack += request.words;
+	hardwareComponents.outputs[jobIndex].queued.push_back(job.writeBuffer);
+	job.writeBuffer.clear();
+}
+
 // Output, Phase 2 (Device signals completion)
 void rmminixOS::handlePUTW_READY( )
 {
@@ -682,28 +991,55 @@ void rmminixOS::handlePUTW_READY( )
 
 assert( theCPU ); // i.e. assert that theCPU is not a null pointer
   int outputDevice = theCPU->trapData;
+	// which request is done - they complete in the order they were made
+	processControlBlock& job = jobTable[outputToJobIndex(outputDevice)];
+	assert( !job.outputRequests.empty() );
+	ioRequest request = job.outputRequests.front();
+	job.outputRequests.pop_front();
+	if(request.async){
+		completeAsyncRequest(outputToJobIndex(outputDevice),request,theCPU->trapStatus,false,0);
+		return;
+	}
+	if(request.writeBack&&0==theCPU->trapStatus){
+		int latency = rmmixHardware::clock-request.issued;
+		writeBacks.blocks++;
+		writeBacks.words += request.words;
+		writeBacks.totalLatency += latency;
+		writeBacks.maxLatency = std::max(writeBacks.maxLatency,latency);
+		job.wordsWritingBack -= request.words;
+		theCPU->trapData=theCPU->trapStatus=theCPU->trapNumber=0;
+		wakeUp(outputToJobIndex(outputDevice));
+		//if the job is finished already, its files are no longer needed
+		releaseJobIO(outputToJobIndex(outputDevice));
+		return;
+	}
+	// (if a block could not be written, the job crashes - just like a PUTW)
     // The hardware has signaled that the put-word operation is done.
     if ( 0 != theCPU->trapStatus ) {
         // trigger fatal interrupt (crash current process)
-	 osVector->at(outputToJobIndex(outputDevice))->close();
+	unblockJob(outputToJobIndex(outputDevice));
         theCPU->trapNumber = RMMIX_JDL::FATAL;
 	fatalInterruptIndex = outputToJobIndex(outputDevice); //os need to know which job caused the fatal interrupt
     } else { // if OK status
         // Check if the device number is OK
       
-	osVector->at(outputToJobIndex(outputDevice))->close();
         //assert( 1 == outputDevice ); // This will change later!
         assert( hardwareComponents[ outputDevice ] ); // not null
 	clearInterrupts(outputToJobIndex(outputDevice));
 	theCPU->trapData=theCPU->trapStatus=theCPU->trapNumber=0;
 	hardwareComponents[ outputDevice ]->trapData = hardwareComponents[ outputDevice ]->trapStatus = hardwareComponents[outputDevice ]->trapNumber = 0;
 	//this only happens if only 1 job is left and it was waiting
-       waitingForIOStatus->at(outputToJobIndex(outputDevice))=true;
+       unblockJob(outputToJobIndex(outputDevice));
 	//check if the cpu was ideling cause no other job was there
-        if(theCPU->registers[0]== -1){
-		executeJobChange(outputToJobIndex(outputDevice),true);
+        if(theCPU->registers[0]== -1&&!scheduler->empty()){
+		executeJobChange(getNextWaitingJob(),true);
 	
+	}else{
+		//or should the job get the cpu right away?
+		preemptFor(outputToJobIndex(outputDevice));
 	}
+	//if the job is finished already, its files are no longer needed
+	releaseJobIO(outputToJobIndex(outputDevice));
 
 
 
@@ -712,3 +1048,285 @@ assert( theCPU ); // i.e. assert that theCPU is not a null pointer
 } // end handlePUTW_READY
 
 
+// =====================================================================
+//       Block I/O - like GETW and PUTW, but a whole block of words is
+//       moved between the job's input or output and the data memory
+//       (by the DMA controller), with only one interrupt at the end.
+
+void rmminixOS::handleGETB( )
+{
+	startBlockTransfer(RMMIX_JDL::GETB);
+} // end handleGETB
+
+void rmminixOS::handlePUTB( )
+{
+	startBlockTransfer(RMMIX_JDL::PUTB);
+} // end handlePUTB
+
+void rmminixOS::startBlockTransfer(int trap)
+{
+	assert( theCPU ); // i.e. assert that theCPU is not a null pointer
+	int jobIndex = currentJobIndex;
+	processControlBlock& job = jobTable[jobIndex];
+	//the block starts at the address in register X, and the next register
+	//says how many words it has
+	int reg = theCPU->trapData;
+	bool blockOK = (0 <= reg) && (reg+1 < theCPU->numberOfRegisters);
+	int address = blockOK ? theCPU->registers[reg] : 0;
+	int count = blockOK ? theCPU->registers[reg+1] : 0;
+	if(!blockOK||address<0||count<0||theCPU->dataMemorySize-count<address){
+		//crash the job, just like any other illegal instruction
+		theCPU->trapNumber = RMMIX_JDL::FATAL;
+		theCPU->trapData = theCPU->trapStatus = 0;
+		return;
+	}
+	//the same output file as PUTW (see handlePUTW)
+	if(RMMIX_JDL::PUTB==trap&&!job.io->output.is_open()){
+		job.io->output.open(getOutputFilename(jobIndex));
+	}
+	//after the words the job has written before
+	if(RMMIX_JDL::PUTB==trap&&(!job.writeBuffer.empty()||job.wordsWritingBack)){
+		writeBack(jobIndex);
+		waitForCompletion(jobIndex);
+		return;
+	}
+
+	// Program the job's channel of the dma controller
+	rmmixDMADevice::channel& channel = hardwareComponents.addDMA()->channels[jobIndex];
+	assert( !channel.trapNumber && !channel.transfer ); // the job was running
+	channel.trapNumber = trap;
+	channel.address = address;
+	channel.count = count;
+	channel.source = &job.io->decompiler;
+	channel.sink = &job.io->output;
+	clearInterrupts(jobIndex);
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+
+	//the job waits for the whole block - try to switch to another job
+	blockJob(jobIndex);
+	if(!switchProgramm()){
+		saveRegisters();
+		idleCPU(); // make the cpu wait!
+	}
+
+} // end startBlockTransfer
+
+void rmminixOS::handleBLOCK_READY( )
+{
+	assert( theCPU ); // i.e. assert that theCPU is not a null pointer
+	int jobIndex = theCPU->trapData; // the dma channel is the job's
+	if ( 0 != theCPU->trapStatus ) {
+		// trigger fatal interrupt (crash the job - e.g. not enough input)
+		unblockJob(jobIndex);
+		theCPU->trapNumber = RMMIX_JDL::FATAL;
+		fatalInterruptIndex = jobIndex;
+	} else { // if OK status - the words are already in place
+		clearInterrupts(jobIndex);
+		theCPU->trapData=theCPU->trapStatus=theCPU->trapNumber=0;
+		unblockJob(jobIndex);
+		//check if the cpu was ideling cause no other job was there
+		if(theCPU->registers[0]== -1&&!scheduler->empty()){
+			executeJobChange(getNextWaitingJob(),true);
+		}else{
+			//or should the job get the cpu right away?
+			preemptFor(jobIndex);
+		}
+		//if the job is finished already, its files are no longer needed
+		releaseJobIO(jobIndex);
+	};
+} // end handleBLOCK_READY
+
+
+// =====================================================================
+//       Asynchronous I/O - the job submits requests for its input and
+//       output devices (see RMMIXcodes.h) through rings in the data
+//       memory, goes on computing, and reaps the completions later.
+
+namespace {
+
+// Where the parts of the job's rings are (see rmminixos.h)
+enum ringField { submissionHead, submissionTail, completionHead, completionTail,
+                 ringHeader };
+
+int& ringWord(const rmminixOS::processControlBlock& job,int field){
+	return theCPU->dataMemory[job.ringAddress+field];
+}
+
+int& submissionEntry(const rmminixOS::processControlBlock& job,int n,int word){
+	return theCPU->dataMemory[job.ringAddress+ringHeader+3*(n%job.ringEntries)+word];
+}
+
+int& completionEntry(const rmminixOS::processControlBlock& job,int n,int word){
+	return theCPU->dataMemory[job.ringAddress+ringHeader+3*job.ringEntries+
+	                          2*(n%job.ringEntries)+word];
+}
+
+//the heads and tails belong to the job - they may be anything
+bool ringsOK(const rmminixOS::processControlBlock& job){
+	int submitted = ringWord(job,submissionTail)-ringWord(job,submissionHead);
+	int completed = ringWord(job,completionTail)-ringWord(job,completionHead);
+	return job.ringEntries>0&&ringWord(job,submissionHead)>=0&&ringWord(job,completionHead)>=0&&
+	       submitted>=0&&submitted<=job.ringEntries&&completed>=0&&completed<=job.ringEntries;
+}
+
+} // end anonymous namespace
+
+void rmminixOS::handleRING( )
+{
+	assert( theCPU ); // i.e. assert that theCPU is not a null pointer
+	processControlBlock& job = jobTable[currentJobIndex];
+	int reg = theCPU->trapData;
+	bool ringOK = (0 <= reg) && (reg+1 < theCPU->numberOfRegisters) && !job.asyncInFlight;
+	int address = ringOK ? theCPU->registers[reg] : 0;
+	int entries = ringOK ? theCPU->registers[reg+1] : 0;
+	//the rings must fit into the data memory (and cannot move while in use)
+	if(!ringOK||address<0||entries<=0||
+	   (theCPU->dataMemorySize-ringHeader-address)/5<entries){
+		theCPU->trapNumber = RMMIX_JDL::FATAL;
+		theCPU->trapData = theCPU->trapStatus = 0;
+		return;
+	}
+	job.ringAddress = address;
+	job.ringEntries = entries;
+	for(int field=0;field<ringHeader;field++){
+		ringWord(job,field) = 0;
+	}
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+} // end handleRING
+
+void rmminixOS::handleSUBMIT( )
+{
+	assert( theCPU ); // i.e. assert that theCPU is not a null pointer
+	int jobIndex = currentJobIndex;
+	processControlBlock& job = jobTable[jobIndex];
+	int reg = theCPU->trapData;
+	if(!ringsOK(job)){
+		theCPU->trapNumber = RMMIX_JDL::FATAL;
+		theCPU->trapData = theCPU->trapStatus = 0;
+		return;
+	}
+	//take requests as long as the completion ring has room for all of them
+	int submitted = 0;
+	for(int& head = ringWord(job,submissionHead);
+	    head!=ringWord(job,submissionTail)&&
+	    ringWord(job,completionTail)-ringWord(job,completionHead)+job.asyncInFlight<job.ringEntries;
+	    head++,submitted++){
+		ioRequest request;
+		request.async = true;
+		request.address = submissionEntry(job,head,1);
+		request.tag = submissionEntry(job,head,2);
+		int op = submissionEntry(job,head,0);
+		if(request.address<0||theCPU->dataMemorySize<=request.address||
+		   (RMMIX_JDL::GETW!=op&&RMMIX_JDL::PUTW!=op)){
+			//a bad request fails right away
+			completionEntry(job,ringWord(job,completionTail),0) = request.tag;
+			completionEntry(job,ringWord(job,completionTail),1) = 1;
+			ringWord(job,completionTail)++;
+		}else if(RMMIX_JDL::GETW==op){
+			hardwareComponents.inputs[jobIndex].queued.push_back(1);
+			job.inputRequests.push_back(request);
+			job.asyncInFlight++;
+		}else{
+			//the same output file as PUTW (see handlePUTW) - after the
+			//words the job has written before
+			if(!job.io->output.is_open()){
+				job.io->output.open(getOutputFilename(jobIndex));
+			}
+			writeBack(jobIndex);
+			hardwareComponents.outputs[jobIndex].queued.push_back({theCPU->dataMemory[request.address]});
+			job.outputRequests.push_back(request);
+			job.asyncInFlight++;
+		}
+	}
+	//the job goes on right away
+	theCPU->registers[reg] = submitted;
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+} // end handleSUBMIT
+
+void rmminixOS::handleREAP( )
+{
+	assert( theCPU ); // i.e. assert that theCPU is not a null pointer
+	processControlBlock& job = jobTable[currentJobIndex];
+	int reg = theCPU->trapData;
+	if(!ringsOK(job)){
+		theCPU->trapNumber = RMMIX_JDL::FATAL;
+		theCPU->trapData = theCPU->trapStatus = 0;
+		return;
+	}
+	int completed = ringWord(job,completionTail)-ringWord(job,completionHead);
+	//nothing to reap yet - wait, unless there is nothing to wait for
+	if(0==completed&&job.asyncInFlight){
+		waitForCompletion(currentJobIndex);
+		return;
+	}
+	theCPU->registers[reg] = completed;
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+} // end handleREAP
+
+void rmminixOS::waitForCompletion(int jobIndex){
+	//back to the trap instruction, which is executed again when the job
+	//gets the cpu back (after one of its requests is done)
+	theCPU->registers[0]--;
+	theCPU->trapNumber = theCPU->trapData = theCPU->trapStatus = 0;
+	jobTable[jobIndex].waitingForCompletion = true;
+	blockJob(jobIndex);
+	if(!switchProgramm()){
+		saveRegisters();
+		idleCPU(); // make the cpu wait!
+	}
+}
+
+void rmminixOS::completeAsyncRequest(int jobIndex,const ioRequest& request,int status,
+                                     bool input,int word){
+	processControlBlock& job = jobTable[jobIndex];
+	theCPU->trapData=theCPU->trapStatus=theCPU->trapNumber=0;
+	job.asyncInFlight--;
+	if(input&&0==status){
+		theCPU->dataMemory[request.address] = word;
+	}
+	//there is room, see handleSUBMIT
+	completionEntry(job,ringWord(job,completionTail),0) = request.tag;
+	completionEntry(job,ringWord(job,completionTail),1) = status;
+	ringWord(job,completionTail)++;
+
+	wakeUp(jobIndex);
+	//if the job is finished already, its files are no longer needed
+	releaseJobIO(jobIndex);
+}
+
+void rmminixOS::wakeUp(int jobIndex){
+	processControlBlock& job = jobTable[jobIndex];
+	if(job.waitingForCompletion&&job.state==processControlBlock::blocked){
+		job.waitingForCompletion = false;
+		unblockJob(jobIndex);
+		//check if the cpu was ideling cause no other job was there
+		if(theCPU->registers[0]== -1&&!scheduler->empty()){
+			executeJobChange(getNextWaitingJob(),true);
+		}else{
+			//or should the job get the cpu right away?
+			preemptFor(jobIndex);
+		}
+	}
+}
+
+void rmminixOS::cancelIO(int jobIndex){
+	processControlBlock& job = jobTable[jobIndex];
+	hardwareComponents.inputs[jobIndex].cancel();
+	//but what the job has written is written, at once
+	if(!job.writeBuffer.empty()){
+		hardwareComponents.outputs[jobIndex].queued.push_back(job.writeBuffer);
+		job.writeBuffer.clear();
+	}
+	hardwareComponents.outputs[jobIndex].finish();
+	job.wordsWritingBack = 0;
+	job.inputRequests.clear();
+	job.outputRequests.clear();
+	job.asyncInFlight = 0;
+	job.waitingForCompletion = false;
+	job.readAhead.clear();
+	job.readAheadInFlight = 0;
+	job.endOfInput = false;
+	job.waitingForInput = false;
+}
+
+
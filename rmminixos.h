@@ -29,17 +29,196 @@
 #define RMMINIXOS_H_
 
 #include "rmmixHardware.h"
+#include "rmminixOutput.h"
+#include <deque>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace rmminixOS {
+
+    // "No job" - the end of a job queue, or no job to switch to
+    const int noJob = -1;
+
+    // A job's I/O context - the object file, which its input device reads
+    // (after $RUN), and the channel its output device writes to (opened
+    // for each subjob, see handlePUTW).  Created when the job is booted,
+    // released when it is finished (see releaseJobIO).
+    struct jobIOContext {
+        objectCodeDecompiler decompiler;
+        outputChannel        output;
+
+        jobIOContext( const char* filename, outputChannel::writerType writer )
+        : decompiler( filename ), output( writer ) { };
+    }; // end jobIOContext
+
+    // A request to a job's input or output device, in flight: either for
+    // GETW resp. PUTW (the job waits for it), a burst read ahead (see
+    // readAheadPolicy), a block of words written back (see
+    // writeCombiningPolicy - issued is the clock tick of the block's first
+    // PUTW), or submitted asynchronously (see handleSUBMIT) - then the
+    // word read goes to address, and the completion is tagged with tag.
+    struct ioRequest {
+        bool async     = false;
+        bool readAhead = false;
+        bool writeBack = false;
+        int  address   = 0;
+        int  tag       = 0;
+        int  words     = 1;
+        int  issued    = 0;
+    };
+
+    // Read-ahead for GETW (rmmixsim --readahead=DEPTH[:BURST]): the OS keeps
+    // up to depth words of each job's input in a buffer, which the input
+    // device fills a burst of words at a time, for the delay of one word.
+    // A GETW takes its word from the buffer, and only waits for the device
+    // when the buffer is empty.  The next burst is read as soon as there is
+    // room for it - the default burst, half the depth, keeps one half of the
+    // buffer filling while the job uses the other.  depth 0 (the default) =
+    // no read-ahead, every GETW waits for the device.  Words read ahead are
+    // not seen by getb or asynchronous getw - these read the words after them.
+    struct readAheadPolicy {
+        int depth = 0;
+        int burst = 0;
+    };
+
+    // Parses DEPTH[:BURST] (empty = no read-ahead) - throws a std::string
+    // if the spec is no good.
+    readAheadPolicy makeReadAheadPolicy( const std::string& spec );
+
+    // Write-combining for PUTW (rmmixsim --combine=SIZE[:LIMIT]): the OS
+    // collects the words each job writes in a buffer, and the job goes on
+    // right away.  Once there are size words, they are written back to the
+    // output device as one block (for the delay of one word) - and so is
+    // whatever is left when the job halts or crashes.  A job which has
+    // limit words (default: twice size) in its buffer or being written back
+    // waits until a block is done.  size 0 (the default) = no buffer, every
+    // PUTW waits for the device.
+    struct writeCombiningPolicy {
+        int size  = 0;
+        int limit = 0;
+    };
+
+    // Parses SIZE[:LIMIT] (empty = no write-combining) - throws a
+    // std::string if the spec is no good.
+    writeCombiningPolicy makeWriteCombiningPolicy( const std::string& spec );
+
+    // How long the words written back waited for the device (in clock
+    // ticks, from the PUTW of each block's first word until the block was
+    // written) - rmmixsim --stats
+    struct writeBackStatistics {
+        int       blocks       = 0;
+        long long words        = 0;
+        long long totalLatency = 0;
+        int       maxLatency   = 0;
+    };
+
+    const writeBackStatistics& writeBackStats( );
+
+    // Process Control Block - everything the OS knows about one job.
+    // There is one per job file on the command line (see boot), kept in
+    // one table, and a job's number is its index in that table.
+    struct processControlBlock {
+        // A job is notBooted until it first gets the CPU, then it is
+        // running, ready (to run, waiting for the CPU), blocked (waiting
+        // for I/O), until it is finished (for good).  notBooted and ready
+        // jobs are in the ready queue, blocked jobs in the blocked queue.
+        enum stateType : char { notBooted, ready, running, blocked, finished };
+        stateType state = notBooted;
+
+        // The links in the job's queue (see jobQueue)
+        int next     = noJob;
+        int previous = noJob;
+
+        char* filename = nullptr;  // the object file (from the command line)
+        std::unique_ptr< jobIOContext > io; // nullptr unless booted & not finished
+        int subJob = 0;            // number of the current $JOB in the file
+
+        // The register bank - while the job runs, the CPU works in it
+        std::vector< int > registers = std::vector< int >( 32 );
+
+        // The trap registers of the CPU, saved while the job doesn't run,
+        // and the register which will get the word read by GETW.
+        int trapNumber  = 0;
+        int trapData    = 0;
+        int trapStatus  = 0;
+        int regToUpdate = 0;
+
+        // The code segment (packed when loaded), and the same, pre-decoded
+        // for the threadedEngine
+        packedProgram  program;
+        decodedProgram decoded;
+
+        // Asynchronous I/O (see handleRING): where the rings are (0 entries
+        // = no rings), the requests in flight, per device in the order they
+        // will complete, and whether the job waits for one of them
+        int                     ringAddress = 0;
+        int                     ringEntries = 0;
+        int                     asyncInFlight = 0;
+        std::deque< ioRequest > inputRequests;
+        std::deque< ioRequest > outputRequests;
+        bool                    waitingForCompletion = false;
+
+        // Read-ahead (see readAheadPolicy): the words read for the job's
+        // GETWs, how many the burst in flight asks for (0 = none), whether
+        // its input is used up, and whether it waits for the next burst
+        std::deque< int > readAhead;
+        int               readAheadInFlight = 0;
+        bool              endOfInput = false;
+        bool              waitingForInput = false;
+
+        // Write-combining (see writeCombiningPolicy): the words written by
+        // the job's PUTWs, the clock tick of the first one, and how many
+        // words are being written back
+        std::vector< int > writeBuffer;
+        int                writeBufferSince = 0;
+        int                wordsWritingBack = 0;
+
+        // For the scheduling policies (see rmminixScheduler.h)
+        int level         = 0;  // priority resp. MLFQ level - 0 goes first
+        int burstEstimate = 0;  // expected CPU burst (in clock ticks)
+        int dispatchTime  = 0;  // clock tick at which it last got the CPU
+    }; // end processControlBlock
+
+    // A FIFO queue of jobs, linked through the jobs' own control blocks
+    // (next, previous), so that push, pop and removing any job are O(1)
+    // and need no memory.  A job can be in at most one queue at a time.
+    class jobQueue {
+    public:
+        jobQueue( std::vector< processControlBlock >& table ) : jobs( table ) { };
+
+        bool empty( ) const { return noJob == head; }
+        int  front( ) const { return head; } // noJob if empty
+        int  size( )  const { return length; }
+
+        void push( int job );   // to the end of the queue
+        int  pop( );            // from the front (noJob if empty)
+        void remove( int job ); // from anywhere in the queue
+
+    private:
+        std::vector< processControlBlock >& jobs;
+        int head   = noJob;
+        int tail   = noJob;
+        int length = 0;
+    }; // end jobQueue
+
     /**
      * boots the first programm
      * @param currentProgIndex provides information which programm is to be
      * booted, importent for the i/o components...I think so
      * @param filename the name of the file that should contain the programm code
+     * @param schedulingPolicy see rmminixScheduler.h (empty = round robin,
+     * each job runs until it blocks or halts)
+     * @param outputWriter how the jobs' output channels write their files
+     * (see rmminixOutput.h)
+     * @param readAheadPolicy see readAheadPolicy (empty = no read-ahead)
+     * @param writeCombiningPolicy see writeCombiningPolicy (empty = none)
      * @return true if everything worked as intened, false if any errors accured
      */
-    bool boot(int argc,char *argv[]);
+    bool boot(int argc,char *argv[],const std::string& schedulingPolicy="",
+              outputChannel::writerType outputWriter=outputChannel::bufferedWriter,
+              const std::string& readAheadPolicy="",
+              const std::string& writeCombiningPolicy="");
 
     //    Load
     // Loads instructions into Instruction memory, by reading an object file.
@@ -63,19 +242,42 @@ namespace rmminixOS {
 
     void removeCurrentJob();
 
+    //the next job to get the cpu, i.e. the front of the ready queue
+    //@return the job's index, or noJob if no job is ready
     int getNextWaitingJob();
     
-    void executeJobChange(int nextJobIndex,bool afterIdle);
+    //@return true if the cpu now runs the next job, false if it could
+    //not be booted (it is finished then, and nothing else has changed)
+    bool executeJobChange(int nextJobIndex,bool afterIdle);
 
-    void saveRegisters();
+    // Moving jobs between the states (and queues), see processControlBlock
+    void blockJob(int jobIndex);
 
-    bool hasBeenBooted(int programmIndex);
+    void unblockJob(int jobIndex);
 
-    void restoreRegState(int nextJobIndex);
-   
-    int getPCof(int programmIndex);
+    void finishJob(int jobIndex);
 
-    void setPCof(int programmIndex,int newPC);
+    void dequeueJob(int jobIndex); // from whichever queue it is in
+
+    //closes the files of a finished job (once its devices are done with them)
+    void releaseJobIO(int jobIndex);
+
+    //closes the output file of the job's current subjob (at HALT or FATAL)
+    void closeOutput(int jobIndex);
+
+    //the job gets the cpu now: starts the timer for its time slice
+    void startQuantum(int jobIndex);
+
+    //no job can run: stops the timer and lets the cpu wait for an interrupt
+    void idleCPU();
+
+    //the job has just become ready - take the cpu away from the current
+    //job, if the scheduling policy says so
+    void preemptFor(int jobIndex);
+
+    void saveRegisters();
+
+    void restoreRegState(int nextJobIndex);
 
     void restoreInstructionMem(int nextJobIndex);
 	
@@ -99,8 +301,33 @@ namespace rmminixOS {
 
     void handleGETW( );
 
+    //GETW with read-ahead - takes the word from the buffer, or waits for it
+    void getWordReadAhead( );
+
+    //starts reading the job's next burst ahead, if there is room for it
+    void readAheadFor(int jobIndex);
+
     void handlePUTW( );
 
+    //PUTW with write-combining - puts the word into the buffer, or waits
+    //for room
+    void putWordCombined( );
+
+    //writes the job's buffered words back to its output device, as a block
+    void writeBack(int jobIndex);
+
+    //after a GETW or PUTW which did not block: finishes the current job, if
+    //that was its last instruction
+    void finishIfDone();
+
+    //block i/o (see rmmixDMADevice): both start a transfer by the job's
+    //dma channel, or crash the job if the block is not in the data memory
+    void handleGETB( );
+
+    void handlePUTB( );
+
+    void startBlockTransfer(int trap);
+
     // Internal Interrupt Handlers
     void handleFATAL();
 
@@ -108,6 +335,49 @@ namespace rmminixOS {
 
     void handlePUTW_READY(  );
 
+    void handleTIMER( );
+
+    void handleBLOCK_READY( );
+
+    // Asynchronous I/O, with a submission and a completion ring in the
+    // data memory.  TRAP ring, X sets them up, for $X+1 entries, at $X:
+    //   $X+0  submission head  (next entry the OS takes)
+    //   $X+1  submission tail  (next entry the job fills in)
+    //   $X+2  completion head  (next completion the job takes)
+    //   $X+3  completion tail  (next completion the OS fills in)
+    //   $X+4  the submission entries - 3 words each: op (getw or putw),
+    //         address (where to put the word read, resp. the word to
+    //         write) and tag (anything - to tell the completions apart),
+    //   then  the completion entries - 2 words each: tag and status
+    //         (0 = OK, 1 = failed).
+    // Heads and tails count up - entry n is at n % entries.  TRAP submit, X
+    // starts the requests from head to tail (as many as there is room for
+    // in the completion ring), without waiting for them, and sets $X to how
+    // many it started.  TRAP reap, X sets $X to the number of completions
+    // - if there are none (yet), the job waits for the next one.  A job
+    // which halts waits until all its requests are done; one which crashes
+    // (FATAL) drops them.
+    void handleRING( );
+
+    void handleSUBMIT( );
+
+    void handleREAP( );
+
+    //the job waits for its next asynchronous request (or block written
+    //back) to complete - then the trap which called this is executed again
+    void waitForCompletion(int jobIndex);
+
+    //a request is done - the job may go on, if it waits (see above)
+    void wakeUp(int jobIndex);
+
+    //an asynchronous request is done: post its completion
+    void completeAsyncRequest(int jobIndex,const ioRequest& request,int status,
+                              bool input,int word);
+
+    //drops all requests to the job's input and output devices, and the
+    //words read ahead - but the words the job has written are written
+    void cancelIO(int jobIndex);
+
 } // end of rmmixOS namespace
 
 #endif /* RMMINIXOS_H_ */
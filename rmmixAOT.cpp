@@ -0,0 +1,305 @@
+// =====================================================================
+// rmmixAOT.cpp - Source code for ahead-of-time compiled RMMIX jobs.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Source File for rmmixAOT.h
+// See rmmixAOT.h for more information
+//
+// =====================================================================
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h> // for dlopen, dlsym
+
+#include "RMMIXcodes.h"
+#include "RMMIXinstruction.h"
+
+#include "rmmixAOT.h"
+
+namespace {
+
+// Same rules as in rmmixJIT.cpp: register 0 (the program counter) and
+// registers which do not exist are left to the interpreter.
+bool registerOK( int r ) {
+    return ( ( 0 < r ) && ( r < 32 ) );
+}
+
+// The job name, as a C++ string literal
+std::string quoted( const std::string& text ) {
+    std::string result( "\"" );
+    for ( char c : text ) {
+        if ( ( '"' == c ) || ( '\\' == c ) )
+            result += '\\';
+        if ( ( ' ' <= c ) && ( c <= '~' ) )
+            result += c;
+        else
+            result += '?';
+    };
+    return result + "\"";
+} // end quoted
+
+// See aotFingerprint (program_type: packed or not)
+template< typename program_type >
+unsigned fingerprint( const program_type& program ) {
+    unsigned hash = 2166136261u;
+    auto mix = [&hash]( int value ) {
+        for ( int i = 0; i < 4; ++i ) {
+            hash ^= ( unsigned( value ) >> ( 8 * i ) ) & 0xff;
+            hash *= 16777619u;
+        }
+    };
+    for ( std::size_t address = 0; address < program.size(); ++address ) {
+        const RMMIXinstruction instruction = program[ address ];
+        mix( instruction.numFields );
+        for ( int i = 0; i < RMMIXinstruction::maxNumFields; ++i )
+            mix( instruction.fields[ i ] );
+    };
+    return hash;
+} // end fingerprint
+
+} // end anonymous namespace
+
+unsigned aotFingerprint( const std::vector< RMMIXinstruction >& program ) {
+    return fingerprint( program );
+} // end aotFingerprint
+
+unsigned aotFingerprint( const packedProgram& program ) {
+    return fingerprint( program );
+} // end aotFingerprint
+
+// =====================================================================
+// aotTranslator
+
+void aotTranslator::addJob( const std::string& jobname,
+                            const std::vector< RMMIXinstruction >& program ) {
+    jobnames.push_back( jobname );
+    programs.push_back( program );
+} // end addJob
+
+void aotTranslator::write( std::ostream& out ) const {
+    out << "// Generated by rmmixaot - do not edit!\n"
+        << "// Compile with -fwrapv (RMMIX arithmetic wraps around).\n\n"
+        << "typedef int (*aotCode_type)( int*, int*, int*, int, int );\n"
+        << "struct aotJobEntry { const char* jobname; int length;"
+        << " unsigned fingerprint; aotCode_type code; };\n\n";
+    for ( int job = 0; job < numberOfJobs(); ++job )
+        writeJob( out, job );
+
+    out << "extern \"C\" const int rmmix_aot_version = " << aotVersion << ";\n"
+        << "extern \"C\" const int rmmix_aot_job_count = " << numberOfJobs()
+        << ";\n"
+        << "extern \"C\" const aotJobEntry rmmix_aot_jobs[] = {\n";
+    for ( int job = 0; job < numberOfJobs(); ++job )
+        out << "    { " << quoted( jobnames[ job ] ) << ", "
+            << programs[ job ].size() << ", "
+            << aotFingerprint( programs[ job ] ) << "u, job" << job << " },\n";
+    out << "};\n";
+} // end write
+
+// One label per instruction - the switch at the start jumps to the
+// instruction in r[ 0 ].  Before each instruction, the budget is checked;
+// every instruction executed is recorded in the trace.
+void aotTranslator::writeJob( std::ostream& out, int jobNumber ) const {
+    const std::vector< RMMIXinstruction >& program = programs[ jobNumber ];
+    const int size = int( program.size() );
+
+    out << "// Job " << quoted( jobnames[ jobNumber ] ) << "\n"
+        << "static int job" << jobNumber
+        << "( int* r, int* m, int* trace, int budget, int memorySize ) {\n"
+        << "    int n = 0;\n"
+        << "    switch ( r[ 0 ] ) {\n";
+    for ( int pc = 0; pc < size; ++pc )
+        out << "    case " << pc << ": goto L" << pc << ";\n";
+    out << "    default: return 0;\n"
+        << "    }\n";
+
+    // leave the function, continuing at address
+    auto leave = [&out]( int address ) {
+        out << "{ r[ 0 ] = " << address << "; return n; }";
+    };
+    // go to the instruction at address
+    auto jumpTo = [&out]( int address ) {
+        out << "goto L" << address << ";";
+    };
+    // Branches out of the program fail verification (see rmmixCPU::verify)
+    // - the interpreter raises FATAL if they are taken
+    auto targetOK = [size]( int address ) {
+        return ( ( 0 <= address ) && ( address < size ) );
+    };
+
+    for ( int pc = 0; pc < size; ++pc ) {
+        const RMMIXinstruction& in = program[ pc ];
+        const int a = in.fields[ 1 ], b = in.fields[ 2 ], c = in.fields[ 3 ];
+
+        // The condition under which the interpreter must take over
+        std::string stop = "n == budget";
+        bool compilable = true;
+        switch ( in.opCode() ) {
+        case RMMIX_JDL::NOP:
+            break;
+        case RMMIX_JDL::JMPI:
+            compilable = targetOK( pc + a + 1 );
+            break;
+        case RMMIX_JDL::MOVI:
+            compilable = registerOK( a );
+            break;
+        case RMMIX_JDL::BEQZI:
+        case RMMIX_JDL::BNEZI:
+        case RMMIX_JDL::BNEGI:
+            compilable = registerOK( a ) && targetOK( pc + b + 1 );
+            break;
+        case RMMIX_JDL::MOV:
+        case RMMIX_JDL::ADDI:
+        case RMMIX_JDL::SUBI:
+        case RMMIX_JDL::MULI:
+            compilable = registerOK( a ) && registerOK( b );
+            break;
+        case RMMIX_JDL::DIVI:
+            compilable = registerOK( a ) && registerOK( b ) && ( 0 != c );
+            break;
+        case RMMIX_JDL::ADD:
+        case RMMIX_JDL::SUB:
+        case RMMIX_JDL::MUL:
+            compilable = registerOK( a ) && registerOK( b ) && registerOK( c );
+            break;
+        case RMMIX_JDL::DIV:
+            compilable = registerOK( a ) && registerOK( b ) && registerOK( c );
+            stop += " || 0 == r[ " + std::to_string( c ) + " ]";
+            break;
+        case RMMIX_JDL::LDWI:
+        case RMMIX_JDL::STWI:
+            compilable = registerOK( a );
+            stop += " || " + std::to_string( b ) + " < 0 || "
+                  + std::to_string( b ) + " >= memorySize";
+            break;
+        case RMMIX_JDL::LDW:
+        case RMMIX_JDL::STW:
+            compilable = registerOK( a ) && registerOK( b );
+            stop += " || unsigned( r[ " + std::to_string( b )
+                  + " ] ) >= unsigned( memorySize )";
+            break;
+        default: // TRAP, illegal op codes
+            compilable = false;
+        }; // end switch on op code
+
+        out << "L" << pc << ": ";
+        if ( ! compilable ) {
+            leave( pc );
+            out << "\n";
+            continue;
+        };
+        out << "if ( " << stop << " ) ";
+        leave( pc );
+        out << "\n    trace[ n++ ] = " << pc << ";\n    ";
+
+        switch ( in.opCode() ) {
+        case RMMIX_JDL::NOP: out << ";"; break;
+        case RMMIX_JDL::MOV:
+            out << "r[ " << a << " ] = r[ " << b << " ];"; break;
+        case RMMIX_JDL::MOVI:
+            out << "r[ " << a << " ] = " << b << ";"; break;
+        case RMMIX_JDL::ADD:
+            out << "r[ " << a << " ] = r[ " << b << " ] + r[ " << c << " ];"; break;
+        case RMMIX_JDL::ADDI:
+            out << "r[ " << a << " ] = r[ " << b << " ] + " << c << ";"; break;
+        case RMMIX_JDL::SUB:
+            out << "r[ " << a << " ] = r[ " << b << " ] - r[ " << c << " ];"; break;
+        case RMMIX_JDL::SUBI:
+            out << "r[ " << a << " ] = r[ " << b << " ] - " << c << ";"; break;
+        case RMMIX_JDL::MUL:
+            out << "r[ " << a << " ] = r[ " << b << " ] * r[ " << c << " ];"; break;
+        case RMMIX_JDL::MULI:
+            out << "r[ " << a << " ] = r[ " << b << " ] * " << c << ";"; break;
+        case RMMIX_JDL::DIV:
+            out << "r[ " << a << " ] = r[ " << b << " ] / r[ " << c << " ];"; break;
+        case RMMIX_JDL::DIVI:
+            out << "r[ " << a << " ] = r[ " << b << " ] / " << c << ";"; break;
+        case RMMIX_JDL::LDWI:
+            out << "r[ " << a << " ] = m[ " << b << " ];"; break;
+        case RMMIX_JDL::LDW:
+            out << "r[ " << a << " ] = m[ r[ " << b << " ] ];"; break;
+        case RMMIX_JDL::STWI:
+            out << "m[ " << b << " ] = r[ " << a << " ];"; break;
+        case RMMIX_JDL::STW:
+            out << "m[ r[ " << b << " ] ] = r[ " << a << " ];"; break;
+        case RMMIX_JDL::JMPI:
+            jumpTo( pc + a + 1 ); break;
+        case RMMIX_JDL::BEQZI:
+            out << "if ( 0 == r[ " << a << " ] ) "; jumpTo( pc + b + 1 ); break;
+        case RMMIX_JDL::BNEZI:
+            out << "if ( 0 != r[ " << a << " ] ) "; jumpTo( pc + b + 1 ); break;
+        case RMMIX_JDL::BNEGI:
+            out << "if ( 0 > r[ " << a << " ] ) "; jumpTo( pc + b + 1 ); break;
+        default: break; // cannot happen - see above
+        }; // end switch on op code
+        out << "\n";
+    }; // end for all instructions
+
+    // Falling off the end of the program
+    out << "L" << size << ": ";
+    leave( size );
+    out << "\n}\n\n";
+} // end writeJob
+
+// =====================================================================
+// aotLibrary
+
+bool aotLibrary::open( const std::string& filename ) {
+    // dlopen only searches the current directory if told to
+    std::string path = filename;
+    if ( std::string::npos == path.find( '/' ) )
+        path = "./" + path;
+
+    void* library = dlopen( path.c_str(), RTLD_NOW | RTLD_LOCAL );
+    if ( nullptr == library ) {
+        error = dlerror();
+        return false;
+    };
+    const int* version =
+        static_cast< const int* >( dlsym( library, "rmmix_aot_version" ) );
+    const int* count =
+        static_cast< const int* >( dlsym( library, "rmmix_aot_job_count" ) );
+    jobs = static_cast< const aotJobEntry* >( dlsym( library, "rmmix_aot_jobs" ) );
+    if ( ( nullptr == version ) || ( nullptr == count ) || ( nullptr == jobs ) ) {
+        error = filename + " was not made by rmmixaot";
+        dlclose( library );
+        jobs = nullptr;
+        return false;
+    };
+    if ( aotVersion != *version ) {
+        error = filename + " was made by a different version of rmmixaot";
+        dlclose( library );
+        jobs = nullptr;
+        return false;
+    };
+    numberOfJobs = *count;
+    return true;
+} // end open
+
+aotCode_type aotLibrary::lookup( const packedProgram& program ) const {
+    const unsigned fingerprint = aotFingerprint( program );
+    for ( int i = 0; i < numberOfJobs; ++i )
+        if ( ( jobs[ i ].length == int( program.size() ) )
+             && ( jobs[ i ].fingerprint == fingerprint ) )
+            return jobs[ i ].code;
+    return nullptr;
+} // end lookup
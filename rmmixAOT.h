@@ -0,0 +1,118 @@
+// =====================================================================
+// rmmixAOT.h - Header file for ahead-of-time compiled RMMIX jobs,
+//              i.e. jobs translated to C++ by rmmixaot, compiled into a
+//              shared library, and loaded by rmmixsim --aot=LIBRARY.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file rmmixAOT.h
+//
+// Each job becomes one C++ function, with one label per instruction and
+// a goto for every jump.  The function starts at the instruction in
+// registers[ 0 ] and runs until
+//  o  it reaches a TRAP (which the CPU then handles as usual, so that
+//     all interrupts still go through rmmixCPU::handleInterrupt),
+//  o  it would divide by zero (the CPU raises FATAL, as usual),
+//  o  it would touch memory outside the data memory, or an instruction
+//     uses register 0 (the program counter), or is illegal, or would
+//     branch out of the program,
+//  o  or it has executed budget instructions.
+// It returns the number of instructions executed, leaves the address of
+// the next instruction in registers[ 0 ], and the addresses of all the
+// instructions executed in trace (so the CPU can log them, see rmmixCPU).
+//
+// The simulator recognizes the right function for a job by its length
+// and fingerprint (a hash of its instructions) - not by its name - so a
+// library can never run code that differs from what was loaded.
+//
+// =====================================================================
+
+#ifndef RMMIXAOT_H_
+#define RMMIXAOT_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "RMMIXinstruction.h"
+
+// Increase this whenever the generated code changes in an incompatible way
+const int aotVersion = 2;
+
+typedef int (*aotCode_type)( int* registers, int* dataMemory, int* trace,
+                             int budget, int dataMemorySize );
+
+// Every library contains a table of these, one per job
+struct aotJobEntry {
+    const char*  jobname;
+    int          length;      // number of instructions
+    unsigned     fingerprint; // see aotFingerprint()
+    aotCode_type code;
+}; // end aotJobEntry
+
+// A hash (FNV-1a) over all fields of all instructions - the same for a
+// program, packed or not
+unsigned aotFingerprint( const std::vector< RMMIXinstruction >& program );
+unsigned aotFingerprint( const packedProgram& program );
+
+/*  class: aotTranslator
+ *******************************************************
+ *  Collects jobs, then writes the C++ source code for a library.
+ *  Used by the rmmixaot program.
+ */
+class aotTranslator {
+public:
+    void addJob( const std::string& jobname,
+                 const std::vector< RMMIXinstruction >& program );
+
+    void write( std::ostream& out ) const;
+
+    int numberOfJobs( ) const { return int( jobnames.size() ); }
+
+private:
+    std::vector< std::string >                       jobnames;
+    std::vector< std::vector< RMMIXinstruction > >   programs;
+
+    void writeJob( std::ostream& out, int jobNumber ) const;
+}; // end aotTranslator
+
+/*  class: aotLibrary
+ *******************************************************
+ *  A library made by rmmixaot, opened with dlopen().
+ *  Used by the rmmixsim program.
+ */
+class aotLibrary {
+public:
+    // Returns true iff the library could be opened, else sets error
+    bool open( const std::string& filename );
+
+    // Returns the native code for program, or nullptr if there is none
+    aotCode_type lookup( const packedProgram& program ) const;
+
+    std::string error;
+
+    // Note: no destructor - the library stays loaded until the simulator
+    // exits, since the CPU may still hold pointers into it.
+
+private:
+    const aotJobEntry* jobs = nullptr;
+    int                numberOfJobs = 0;
+}; // end aotLibrary
+
+#endif /* RMMIXAOT_H_ */
@@ -32,6 +32,7 @@
 #include <fstream>
 #include <string>   // for std::string
 #include <sstream>  // for std::stringstream
+#include <algorithm> // for std::min
 
 // we need some basic knowledge about op codes & the like
 #include "RMMIXJobLang.h"
@@ -52,7 +53,7 @@ int  rmmixHardware::clock       = 0;
 
 
 rmmixCPU* theCPU = nullptr; // C++11!
-std::map< int, rmmixHardware* > hardwareComponents; // global list of hardware
+componentTable hardwareComponents; // global list of hardware
 
 // ===================================>>>> C P U
 // perform whatever instructions are loaded into InstructionMemory
@@ -61,16 +62,32 @@ void rmmixCPU::run( )
 {
 
 
-    if ( trapNumber )
+    if ( deferredTicks ) { // see executeNative()
+        const int address = nativeTrace[ deferredIndex++ ];
+        log() << "execute @ addr " << address
+              << " : " << decodedMemory->listing[ address ] << std::endl;
+        deferredTicks--;
+    }
+    else if ( trapNumber )
         handleInterrupt( );
     else if ( registers[ 0 ] < 0 ) {
         log()<<"idle"<<std::endl;
 		
     }
+    else if ( ( jitEngine == engine ) || ( aotEngine == engine ) )
+        executeNative( );
+    else if ( threadedEngine == engine )
+        executeDecoded( );
     else { // if instruction pointer is positive and no interrupt needs handling
-         RMMIXinstruction instruction = instructionMemory[ registers[ 0 ] ];
+         // (running off the end of the program is an illegal instruction)
+         RMMIXinstruction instruction;
+         if ( instructionMemory && ( registers[ 0 ] < int( instructionMemory->size() ) ) )
+             instruction = ( *instructionMemory )[ registers[ 0 ] ];
 	
-	 executeInstruction(instruction);
+	 if ( instructionMemory && ! instructionMemory->verified() )
+	     executeChecked(instruction);
+	 else
+	     executeInstruction(instruction);
 
     }; // end if instruction Pointer OK and no interrupt needs handling
 } // end of run( )
@@ -80,7 +97,7 @@ void rmmixCPU::run( )
 void rmmixCPU::handleInterrupt( )
 {
     log() << " Interrupt handler - number " << trapNumber
-          << " = " << RMMIX_JDL::lookup( RMMIX_JDL::trapCodes, trapNumber )
+          << " = " << RMMIX_JDL::trapCodeName( trapNumber )
           << ", data " << trapData << std::endl;
 
     switch (trapNumber) {
@@ -109,6 +126,34 @@ void rmmixCPU::handleInterrupt( )
         rmminixOS::handlePUTW_READY(  );
         break;
 
+    case RMMIX_JDL::TIMER:
+        rmminixOS::handleTIMER( );
+        break;
+
+    case RMMIX_JDL::GETB:
+        rmminixOS::handleGETB( );
+        break;
+
+    case RMMIX_JDL::PUTB:
+        rmminixOS::handlePUTB( );
+        break;
+
+    case RMMIX_JDL::BLOCK_READY:
+        rmminixOS::handleBLOCK_READY( );
+        break;
+
+    case RMMIX_JDL::RING:
+        rmminixOS::handleRING( );
+        break;
+
+    case RMMIX_JDL::SUBMIT:
+        rmminixOS::handleSUBMIT( );
+        break;
+
+    case RMMIX_JDL::REAP:
+        rmminixOS::handleREAP( );
+        break;
+
     default: std::string err("Unknown Interrupt passed to HandleInterrupt");
         throw err;
     }; // end switch on trapNumber
@@ -122,6 +167,8 @@ void rmmixCPU::executeInstruction(RMMIXinstruction& instruction)
 
     log() << "execute @ addr " << registers[0]
           << " : " << instruction.dump() << std::endl;
+    ++dispatches;
+    ++instructionsExecuted;
     switch (instruction.fields[0]) // i.e. switch on opcode
     {
     case RMMIX_JDL::NOP: break; // nothing to do here
@@ -211,13 +258,25 @@ void rmmixCPU::executeInstruction(RMMIXinstruction& instruction)
         registers[ instruction.fields[1] ] = dataMemory[ instruction.fields[2] ];
         break;
     case RMMIX_JDL::LDW:
-        registers[ instruction.fields[1] ] = dataMemory[ registers[ instruction.fields[2] ] ];
+        if ( addressOK( registers[ instruction.fields[2] ] ) )
+            registers[ instruction.fields[1] ] = dataMemory[ registers[ instruction.fields[2] ] ];
+        else { // if outside the data memory
+            assert( 0 == trapNumber );
+            trapNumber = RMMIX_JDL::FATAL;
+            trapData = 0;
+        };
         break;
     case RMMIX_JDL::STWI:
         dataMemory[ instruction.fields[2] ] = registers[ instruction.fields[1] ];
         break;
     case RMMIX_JDL::STW:
-        dataMemory[ registers[ instruction.fields[2] ] ] = registers[ instruction.fields[1] ];
+        if ( addressOK( registers[ instruction.fields[2] ] ) )
+            dataMemory[ registers[ instruction.fields[2] ] ] = registers[ instruction.fields[1] ];
+        else { // if outside the data memory
+            assert( 0 == trapNumber );
+            trapNumber = RMMIX_JDL::FATAL;
+            trapData = 0;
+        };
         break;
 
         // If we ever get here, something's very wrong!
@@ -231,39 +290,274 @@ void rmmixCPU::executeInstruction(RMMIXinstruction& instruction)
     registers[ 0 ]++;
 } // end of executeInstricution( )
 
+// The checked path - only for programs which failed verification
+
+void rmmixCPU::executeChecked(RMMIXinstruction& instruction)
+{
+    if ( ! raisesFATAL( instruction.fields[0], instruction.fields[1],
+                        instruction.fields[2], instruction.fields[3],
+                        registers[0], int( instructionMemory->size() ) ) ) {
+        executeInstruction( instruction );
+        return;
+    };
+
+    log() << "execute @ addr " << registers[0]
+          << " : " << instruction.dump() << std::endl;
+    ++dispatches;
+    ++instructionsExecuted;
+    assert( 0 == trapNumber );
+    trapNumber = RMMIX_JDL::FATAL;
+    trapData = 0;
+    registers[ 0 ]++;
+} // end of executeChecked( )
+
+// The Verifier
+
+std::vector< int > rmmixCPU::verify( const packedProgram& program ) const
+{
+    std::vector< int > unverified;
+    const int size = int( program.size() );
+    for ( int address = 0; address < size; ++address ) {
+        const RMMIXinstruction instruction = program[ address ];
+        if ( ! verify( instruction.fields[0], instruction.fields[1],
+                       instruction.fields[2], instruction.fields[3],
+                       address, size ) )
+            unverified.push_back( address );
+    }; // end for all instructions in the program
+    return unverified;
+} // end of verify( program )
+
+bool rmmixCPU::verify( int opCode, int a, int b, int c,
+                       int address, int programSize ) const
+{
+    // where the branch at address goes to, if taken (see executeInstruction)
+    auto targetOK = [address, programSize]( int offset ) {
+        const long long target = (long long)( address ) + offset + 1;
+        return ( ( 0 <= target ) && ( target < programSize ) );
+    };
+
+    switch ( opCode ) {
+    case RMMIX_JDL::NOP:
+        return true;
+    case RMMIX_JDL::MOVI:
+        return registerOK( a );
+    case RMMIX_JDL::MOV:
+    case RMMIX_JDL::ADDI:
+    case RMMIX_JDL::SUBI:
+    case RMMIX_JDL::MULI:
+    case RMMIX_JDL::DIVI:
+    case RMMIX_JDL::LDW:
+    case RMMIX_JDL::STW:
+        return registerOK( a ) && registerOK( b );
+    case RMMIX_JDL::ADD:
+    case RMMIX_JDL::SUB:
+    case RMMIX_JDL::MUL:
+    case RMMIX_JDL::DIV:
+        return registerOK( a ) && registerOK( b ) && registerOK( c );
+    case RMMIX_JDL::JMPI:
+        return targetOK( a );
+    case RMMIX_JDL::BEQZI:
+    case RMMIX_JDL::BNEZI:
+    case RMMIX_JDL::BNEGI:
+        return registerOK( a ) && targetOK( b );
+    case RMMIX_JDL::TRAP: // (the OS takes care of the other traps' data)
+        return ! ( ( RMMIX_JDL::HALT == a ) || ( RMMIX_JDL::GETW == a )
+                   || ( RMMIX_JDL::PUTW == a ) )
+               || registerOK( b );
+    case RMMIX_JDL::LDWI:
+    case RMMIX_JDL::STWI:
+        return registerOK( a ) && addressOK( b );
+    default: // illegal op codes throw an exception anyway
+        return true;
+    }; // end switch on op code
+} // end of verify( instruction )
+
+bool rmmixCPU::raisesFATAL( int opCode, int a, int b, int c,
+                            int address, int programSize ) const
+{
+    if ( verify( opCode, a, b, c, address, programSize ) )
+        return false;
+    switch ( opCode ) { // a branch to nowhere is harmless - if not taken
+    case RMMIX_JDL::BEQZI: return ! registerOK( a ) || ( 0 == registers[ a ] );
+    case RMMIX_JDL::BNEZI: return ! registerOK( a ) || ( 0 != registers[ a ] );
+    case RMMIX_JDL::BNEGI: return ! registerOK( a ) || ( 0 > registers[ a ] );
+    default:               return true;
+    }; // end switch on op code
+} // end of raisesFATAL( )
+
+// The threadedEngine's version of executeInstruction (see above)
+
+void rmmixCPU::executeDecoded( )
+{
+    const int address = registers[ 0 ];
+    if ( ( nullptr == decodedMemory ) || ( decodedMemory->size() <= address ) ) {
+        // ran off the end of the program - same as an illegal instruction
+        log() << "execute @ addr " << address
+              << " : " << RMMIXinstruction().dump() << std::endl;
+        std::string err("Illegal Op Code ");
+        throw err;
+    };
+
+    log() << "execute @ addr " << address
+          << " : " << decodedMemory->listing[ address ] << std::endl;
+
+    // The handler also increments the program counter
+    const decodedInstruction& instruction = decodedMemory->code[ address ];
+    ++dispatches;
+    if ( instruction.fusedHandler
+         && ( decodedInstruction::fusedLength <= ticksUntilInterrupt() ) ) {
+        // A superinstruction - the second instruction is logged (and its
+        // clock tick spent) next time, just like after native code.
+        instruction.fusedHandler( *this, instruction );
+        instructionsExecuted += decodedInstruction::fusedLength;
+        nativeTrace[ 1 ] = address + 1;
+        deferredIndex = 1;
+        deferredTicks = decodedInstruction::fusedLength - 1;
+    }
+    else {
+        instruction.handler( *this, instruction );
+        ++instructionsExecuted;
+    };
+} // end of executeDecoded( )
+
+// The jit & aot engines' version of executeInstruction (see above)
+
+void rmmixCPU::executeNative( )
+{
+    const int address = registers[ 0 ];
+
+    // Native code may only run if no interrupt can arrive before it's done
+    const int budget = std::min( ticksUntilInterrupt(), int( maxNativeRun ) );
+    int executed = 0;
+    if ( ( nullptr == decodedMemory ) || ( address >= decodedMemory->size() ) )
+        ; // nothing to run - executeDecoded will complain
+    else if ( aotEngine == engine ) {
+        if ( decodedMemory->aotCode )
+            executed = decodedMemory->aotCode( registers, dataMemory.data(),
+                                               nativeTrace.data(), budget,
+                                               dataMemorySize );
+    }
+    else {
+        const jitBlock* block =
+            decodedMemory->jit.reach( *decodedMemory, address, dataMemorySize );
+        if ( block && ( block->length <= budget ) ) {
+            executed = block->nativeCode( registers, dataMemory.data() );
+            for ( int i = 0; i < executed; ++i ) // blocks run straight through
+                nativeTrace[ i ] = address + i;
+        };
+    }; // end if jitEngine
+
+    if ( 0 == executed ) {
+        executeDecoded( );
+        return;
+    };
+
+    ++dispatches;
+    instructionsExecuted += executed;
+
+    // The first instruction counts as this tick, the rest are owed
+    log() << "execute @ addr " << address
+          << " : " << decodedMemory->listing[ address ] << std::endl;
+    deferredIndex = 1;
+    deferredTicks = executed - 1;
+} // end of executeNative( )
+
+int rmmixCPU::ticksUntilInterrupt( ) const
+{
+    return hardwareComponents.quietTicks();
+} // end of ticksUntilInterrupt( )
+
+int rmmixCPU::idleTicks( ) const
+{
+    if ( ( 0 == deferredTicks ) && ( 0 == trapNumber ) && ( registers[ 0 ] < 0 ) )
+        return forever; // until some device interrupts
+    else
+        return 0;
+} // end of idleTicks( )
+
+int skipIdleTicks( int limit )
+{
+    const int ticks = std::min( limit, hardwareComponents.idleTicks() );
+    if ( ticks <= 0 ) return 0;
+
+    hardwareComponents.skip( ticks );
+    rmmixHardware::logStream << rmmixHardware::clock << ": skipped " << ticks
+                             << " idle ticks" << std::endl;
+    rmmixHardware::clock += ticks;
+    return ticks;
+} // end of skipIdleTicks( )
+
+// An input device interrupts the CPU in the tick after its count down
+// reaches zero - or, if it is about to serve a request, inputDelay ticks
+// later.
+
+int rmmixInputDevice::quietTicks( ) const {
+    if ( countDownTimer )
+        return countDownTimer;
+    else if ( ( RMMIX_JDL::GETW == trapNumber ) || ! queued.empty() )
+        return inputDelay + 1;
+    else
+        return forever;
+}
+
+// Counting down is idle - except for the tick in which the count down
+// reaches zero.
+
+int rmmixInputDevice::idleTicks( ) const {
+    if ( countDownTimer )
+        return countDownTimer - 1;
+    else if ( ( RMMIX_JDL::GETW == trapNumber ) || ! queued.empty() )
+        return 0;
+    else
+        return forever;
+}
+
+void rmmixInputDevice::cancel( ) {
+    trapNumber = trapData = trapStatus = 0;
+    countDownTimer = 0;
+    queued.clear();
+    received.clear();
+    hardwareComponents.interrupts.withdraw( deviceNumber );
+}
+
 void rmmixInputDevice::run( ) {
 
     assert( (0 == trapNumber) || (RMMIX_JDL::GETW == trapNumber));
     if ( RMMIX_JDL::GETW == trapNumber ) {
-        countDownTimer = inputDelay;
+        queued.push_back( 1 ); // one word
         // clear interrupt
         trapNumber = trapData = trapStatus = 0;
+    };
+    if ( ! queued.empty() && ( 0 == countDownTimer ) ) { // serve the next request
+        words = queued.front();
+        queued.pop_front();
+        countDownTimer = inputDelay;
         log() << "starting delay" << std::endl;
 	} else if ( countDownTimer ) {
         countDownTimer--;
         log() << "Delay down to " << countDownTimer << std::endl;
         if ( 0 == countDownTimer ) {
-            assert( theCPU );
-            // Is the CPU ready for this interrupt?
-            if ( 0 != theCPU->trapNumber )
-                countDownTimer = 1; // wait one more cycle...
-            else { // if the CPU is ready
-                theCPU->trapNumber = RMMIX_JDL::GETW_READY;
-                trapNumber = 0; // clear my trapnumber
-
-                // Read Number from decompiler object into MY trapData word!!!
-                bool OK = ( *decompiler >> trapData );
-		 // tell the CPU that she can pick up the data
-                theCPU->trapStatus = ( !OK ); // if OK, set status to zero...
-                theCPU->trapNumber = RMMIX_JDL::GETW_READY;
-                theCPU->trapData = deviceNumber; // Tell the CPU which input
-                                                 // Device is finished.
-		log() << "signaled trap " << theCPU->trapNumber
-                     << ", data = " <<       theCPU->trapData
-                    << ", status = " <<      theCPU->trapStatus
-                    << std::endl;
-	
-            }; // end if the CPU is ready
+            trapNumber = 0; // clear my trapnumber
+
+            // Read the words from the decompiler object, and keep them
+            // until the OS takes them - a burst ends early at the end of
+            // the job's input (then the request failed)
+            std::vector< int > read;
+            for ( int word; ( int( read.size() ) < words ) && bool( *decompiler >> word ); )
+                read.push_back( word );
+            bool OK = ( int( read.size() ) == words );
+            if ( 1 < words )
+                log() << "read " << read.size() << " of " << words << " words" << std::endl;
+            received.push_back( read );
+            // tell the CPU that she can pick up the data - as soon as she
+            // is ready for the interrupt (see rmmixInterruptController)
+            hardwareComponents.interrupts.raise( deviceNumber, RMMIX_JDL::GETW_READY,
+                                                 deviceNumber, // which input
+                                                 !OK ); // if OK, status zero
+            log() << "signaled trap " << RMMIX_JDL::GETW_READY
+                  << ", data = " <<       deviceNumber
+                  << ", status = " <<     !OK
+                  << std::endl;
         }; // end if we just counted down to zero
     } else { // if countDownTimer == 0, do nothing
         log() << "idle." << std::endl;
@@ -272,45 +566,81 @@ void rmmixInputDevice::run( ) {
 
 }
 
+// Same for output devices
+
+int rmmixOutputDevice::quietTicks( ) const {
+    if ( countDownTimer )
+        return countDownTimer;
+    else if ( ( RMMIX_JDL::PUTW == trapNumber ) || ! queued.empty() )
+        return outputDelay + 1;
+    else
+        return forever;
+}
+
+int rmmixOutputDevice::idleTicks( ) const {
+    if ( countDownTimer )
+        return countDownTimer - 1;
+    else if ( ( RMMIX_JDL::PUTW == trapNumber ) || ! queued.empty() )
+        return 0;
+    else
+        return forever;
+}
+
+void rmmixOutputDevice::cancel( ) {
+    trapNumber = trapData = trapStatus = 0;
+    countDownTimer = 0;
+    queued.clear();
+    hardwareComponents.interrupts.withdraw( deviceNumber );
+}
+
+void rmmixOutputDevice::finish( ) {
+    if ( RMMIX_JDL::PUTW == trapNumber )
+        queued.push_back( { trapData } );
+    if ( countDownTimer ) // else the words have been written already
+        queued.push_front( buffer );
+    for ( const std::vector< int >& words : queued )
+        for ( int word : words )
+            if ( outputSink )
+                *outputSink << word << '\n';
+    if ( ! queued.empty() )
+        log() << "finished " << queued.size() << " requests at once" << std::endl;
+    cancel();
+}
+
 void rmmixOutputDevice::run( ) {
 
 	
     assert( (0 == trapNumber) || (RMMIX_JDL::PUTW == trapNumber));
     if ( RMMIX_JDL::PUTW == trapNumber ) {
-	 
-	countDownTimer = outputDelay;
-        buffer = trapData;
-
-
+        queued.push_back( { trapData } ); // one word
         // clear interrupt
         trapNumber = trapData = trapStatus = 0;
-        log() << "starting delay, buffered reg[" << trapData
-               << "] = " << buffer << std::endl;
+    };
+    if ( ! queued.empty() && ( 0 == countDownTimer ) ) { // serve the next request
+	countDownTimer = outputDelay;
+        buffer = queued.front();
+        queued.pop_front();
+        if ( 1 == buffer.size() )
+            log() << "starting delay, buffered reg[" << trapData
+                   << "] = " << buffer.front() << std::endl;
+        else
+            log() << "starting delay, buffered " << buffer.size() << " words" << std::endl;
     } else if ( countDownTimer ) {
 	        
 	countDownTimer--;
         log() << "Delay down to " << countDownTimer << std::endl;
         if ( 0 == countDownTimer ) {
-            assert( theCPU );
-            // Is the CPU ready for this interrupt?
-            if ( 0 != theCPU->trapNumber )
-                countDownTimer = 1; // wait one more cycle...
-		
-            else { // if the CPU is ready
-		
-                theCPU->trapNumber = RMMIX_JDL::PUTW_READY;
-                theCPU->trapData = deviceNumber; // Tell the CPU which output
-                   
-                // Here is the actual output...
-		
-                bool OK = ( *outputSink << buffer << std::endl );
-		
-		
-		theCPU->trapStatus = ( !OK ); // if OK, set status to zero...
-                log() << "signaling trap " << theCPU->trapNumber
-                      << ", status = "     << theCPU->trapStatus
-                      << std::endl;
-            }; // end if the CPU is ready
+            // Here is the actual output...
+            for ( int word : buffer )
+                *outputSink << word << '\n'; // no flush (see closeOutput)
+            bool OK = bool( *outputSink );
+
+            hardwareComponents.interrupts.raise( deviceNumber, RMMIX_JDL::PUTW_READY,
+                                                 deviceNumber, // which output
+                                                 !OK ); // if OK, status zero
+            log() << "signaling trap " << RMMIX_JDL::PUTW_READY
+                  << ", status = "     << !OK
+                  << std::endl;
         }; // end if we just counted down to zero
     } else { // if countDownTimer == 0, do nothing
         log() << "idle." << std::endl;
@@ -321,4 +651,289 @@ void rmmixOutputDevice::run( ) {
 }
 
 
+// The timer counts down just like the input and output devices - but
+// for as many ticks as the OS asked for.
+
+int rmmixTimerDevice::quietTicks( ) const {
+    if ( RMMIX_JDL::TIMER == trapNumber )
+        return ( trapData ? trapData + 1 : forever );
+    else if ( countDownTimer )
+        return countDownTimer;
+    else
+        return forever;
+}
+
+int rmmixTimerDevice::idleTicks( ) const {
+    if ( RMMIX_JDL::TIMER == trapNumber )
+        return 0;
+    else if ( countDownTimer )
+        return countDownTimer - 1;
+    else
+        return forever;
+}
+
+void rmmixTimerDevice::run( ) {
+
+    assert( (0 == trapNumber) || (RMMIX_JDL::TIMER == trapNumber));
+    if ( RMMIX_JDL::TIMER == trapNumber ) {
+        // a new quantum - the end of the old one (if not yet delivered)
+        // does not matter any more
+        hardwareComponents.interrupts.withdraw( deviceNumber );
+        countDownTimer = trapData;
+        // clear interrupt
+        trapNumber = trapData = trapStatus = 0;
+        if ( countDownTimer )
+            log() << "starting quantum of " << countDownTimer << " ticks" << std::endl;
+        else
+            log() << "stopped." << std::endl;
+    } else if ( countDownTimer ) {
+        countDownTimer--;
+        log() << "Quantum down to " << countDownTimer << std::endl;
+        if ( 0 == countDownTimer ) {
+            hardwareComponents.interrupts.raise( deviceNumber, RMMIX_JDL::TIMER,
+                                                 deviceNumber, 0 );
+            log() << "signaled trap " << RMMIX_JDL::TIMER << std::endl;
+        }; // end if we just counted down to zero
+    } else { // if countDownTimer == 0, do nothing
+        log() << "idle." << std::endl;
+    }
+
+}
+
+
+// The DMA controller counts down like the other devices, but for each
+// channel separately (and only as long as the block takes).
+
+int rmmixDMADevice::quietTicks( ) const {
+    int ticks = forever;
+    for ( const channel& ch : channels )
+        if ( ch.trapNumber )
+            ticks = std::min( ticks, setupDelay + ch.count + 1 );
+        else if ( ch.transfer )
+            ticks = std::min( ticks, ch.countDownTimer );
+    return ticks;
+}
+
+int rmmixDMADevice::idleTicks( ) const {
+    int ticks = forever;
+    for ( const channel& ch : channels )
+        if ( ch.trapNumber )
+            return 0;
+        else if ( ch.transfer )
+            ticks = std::min( ticks, ch.countDownTimer - 1 );
+    return ticks;
+}
+
+void rmmixDMADevice::skip( int ticks ) {
+    for ( channel& ch : channels )
+        if ( ch.transfer ) {
+            assert( ticks < ch.countDownTimer );
+            ch.countDownTimer -= ticks;
+        };
+}
+
+void rmmixDMADevice::run( ) {
+
+    bool busy = false;
+    for ( int ch = 0; ch < int( channels.size() ); ++ch ) {
+        channel& c = channels[ ch ];
+        assert( (0 == c.trapNumber) || (RMMIX_JDL::GETB == c.trapNumber)
+                                    || (RMMIX_JDL::PUTB == c.trapNumber) );
+        if ( c.trapNumber ) {
+            busy = true;
+            c.transfer = c.trapNumber;
+            c.countDownTimer = setupDelay + c.count;
+            // clear interrupt
+            c.trapNumber = 0;
+            log() << "channel " << ch << ": starting transfer of " << c.count
+                  << " words @ addr " << c.address << std::endl;
+        } else if ( c.transfer ) {
+            busy = true;
+            c.countDownTimer--;
+            log() << "channel " << ch << ": Delay down to " << c.countDownTimer
+                  << std::endl;
+            if ( 0 == c.countDownTimer )
+                complete( ch );
+        };
+    }; // end for all channels
+    if ( ! busy ) // nothing to do
+        log() << "idle." << std::endl;
+
+}
+
+void rmmixDMADevice::complete( int ch ) {
+
+    channel& c = channels[ ch ];
+    // Here is the actual transfer - straight from or to the data memory
+    int* memory = theCPU->dataMemory.data() + c.address;
+    bool OK = true;
+    if ( RMMIX_JDL::GETB == c.transfer )
+        for ( int word = 0; OK && ( word < c.count ); ++word )
+            OK = bool( *c.source >> memory[ word ] );
+    else
+        for ( int word = 0; OK && ( word < c.count ); ++word )
+            OK = bool( *c.sink << memory[ word ] << '\n' );
+    c.transfer = 0;
+
+    hardwareComponents.interrupts.raise( deviceNumber, RMMIX_JDL::BLOCK_READY,
+                                         ch, // Tell the CPU which channel (i.e. job)
+                                         !OK ); // if OK, set status to zero...
+    log() << "channel " << ch << ": signaled trap " << RMMIX_JDL::BLOCK_READY
+          << ", status = " << !OK << std::endl;
+
+}
+
+
+// ===================================>>>> The Interrupt Controller
 
+void rmmixInterruptController::raise( int source, int trapNumber,
+                                      int trapData, int trapStatus )
+{
+    queue.insert( pendingInterrupt{ source, raisedSoFar++, trapNumber,
+                                    trapData, trapStatus, rmmixHardware::clock } );
+} // end of raise( )
+
+void rmmixInterruptController::withdraw( int source )
+{
+    for ( auto next = queue.begin(); next != queue.end(); )
+        if ( source == next->source )
+            next = queue.erase( next );
+        else
+            ++next;
+} // end of withdraw( )
+
+void rmmixInterruptController::deliver( rmmixCPU& cpu )
+{
+    if ( 0 != cpu.trapNumber ) // the CPU is not ready (yet)
+        return;
+    for ( auto next = queue.begin(); next != queue.end(); ++next )
+        if ( ! masked( next->source ) ) {
+            cpu.trapNumber = next->trapNumber;
+            cpu.trapData   = next->trapData;
+            cpu.trapStatus = next->trapStatus;
+            const int latency = rmmixHardware::clock - next->raised;
+            ++delivered;
+            totalLatency += latency;
+            maxLatency = std::max( maxLatency, latency );
+            queue.erase( next );
+            return;
+        };
+} // end of deliver( )
+
+void rmmixInterruptController::clear( )
+{
+    queue.clear();
+    maskedSources.clear();
+} // end of clear( )
+
+
+// ===================================>>>> The Component Table
+
+void componentTable::setUp( rmmixCPU* theCPU, int numberOfJobs )
+{
+    cpu = theCPU;
+    inputs.clear();
+    outputs.clear();
+    timers.clear();
+    dmas.clear();
+    interrupts.clear();
+    inputs.reserve( numberOfJobs ); // so that pointers to devices stay valid
+    outputs.reserve( numberOfJobs );
+    for ( int job = 0; job < numberOfJobs; ++job ) {
+        inputs.emplace_back( 2 * job + 1 );
+        outputs.emplace_back( 2 * job + 2 );
+    };
+} // end of setUp( )
+
+rmmixTimerDevice* componentTable::addTimer( )
+{
+    assert( dmas.empty() ); // the timer comes first
+    if ( timers.empty() )
+        timers.emplace_back( 2 * int( inputs.size() ) + 1 );
+    return timer();
+} // end of addTimer( )
+
+rmmixDMADevice* componentTable::addDMA( )
+{
+    if ( dmas.empty() )
+        dmas.emplace_back( 2 * int( inputs.size() ) + 1 + int( timers.size() ),
+                           int( inputs.size() ) ); // one channel per job
+    return dma();
+} // end of addDMA( )
+
+rmmixHardware* componentTable::operator[]( int deviceNumber )
+{
+    if ( 0 == deviceNumber )
+        return cpu;
+    const int job = ( deviceNumber - 1 ) / 2;
+    if ( deviceNumber < 0 )
+        return nullptr;
+    if ( int( inputs.size() ) <= job ) { // the timer or the DMA controller
+        for ( rmmixTimerDevice& device : timers )
+            if ( deviceNumber == device.deviceNumber )
+                return &device;
+        for ( rmmixDMADevice& device : dmas )
+            if ( deviceNumber == device.deviceNumber )
+                return &device;
+        return nullptr;
+    };
+    if ( deviceNumber % 2 )
+        return &inputs[ job ];
+    else
+        return &outputs[ job ];
+} // end of operator[]
+
+void componentTable::run( )
+{
+    cpu->run();
+    for ( std::size_t job = 0; job < inputs.size(); ++job ) {
+        inputs[ job ].run();
+        outputs[ job ].run();
+    };
+    for ( rmmixTimerDevice& device : timers )
+        device.run();
+    for ( rmmixDMADevice& device : dmas )
+        device.run();
+    interrupts.deliver( *cpu );
+} // end of run( )
+
+int componentTable::quietTicks( ) const
+{
+    int ticks = rmmixHardware::forever;
+    for ( const rmmixInputDevice& device : inputs )
+        ticks = std::min( ticks, device.quietTicks() );
+    for ( const rmmixOutputDevice& device : outputs )
+        ticks = std::min( ticks, device.quietTicks() );
+    for ( const rmmixTimerDevice& device : timers )
+        ticks = std::min( ticks, device.quietTicks() );
+    for ( const rmmixDMADevice& device : dmas )
+        ticks = std::min( ticks, device.quietTicks() );
+    return ticks;
+} // end of quietTicks( )
+
+int componentTable::idleTicks( ) const
+{
+    int ticks = cpu->idleTicks();
+    for ( const rmmixInputDevice& device : inputs )
+        ticks = std::min( ticks, device.idleTicks() );
+    for ( const rmmixOutputDevice& device : outputs )
+        ticks = std::min( ticks, device.idleTicks() );
+    for ( const rmmixTimerDevice& device : timers )
+        ticks = std::min( ticks, device.idleTicks() );
+    for ( const rmmixDMADevice& device : dmas )
+        ticks = std::min( ticks, device.idleTicks() );
+    return ticks;
+} // end of idleTicks( )
+
+void componentTable::skip( int ticks )
+{
+    cpu->skip( ticks );
+    for ( rmmixInputDevice& device : inputs )
+        device.skip( ticks );
+    for ( rmmixOutputDevice& device : outputs )
+        device.skip( ticks );
+    for ( rmmixTimerDevice& device : timers )
+        device.skip( ticks );
+    for ( rmmixDMADevice& device : dmas )
+        device.skip( ticks );
+} // end of skip( )
@@ -29,13 +29,18 @@
 #ifndef RMMIXHARDWARE_H_
 #define RMMIXHARDWARE_H_
 
+#include <deque>
 #include <fstream> // for the log file
+#include <set>
 #include <vector>
-#include <map>
+#include <limits> // for std::numeric_limits
 
 #include "RMMIXinstruction.h" // needed for the RMMIXinstruction class
+#include "rmmixMemory.h"      // needed for the data memory
 #include "RMMIXJobLang.h"  // needed for commpiler, decompiler classes
                            // and indirectly for ob codes, trap codes...
+#include "rmmixThreadedCode.h" // needed for the decodedProgram class
+#include "rmmixAOT.h" // needed for the aotLibrary class
 
 class rmmixHardware { // abstract class for deriving hardware subclasses
 public:
@@ -75,14 +80,34 @@ public:
     // Every hardware component MUST overload the bind method!
     virtual void bind( void *pointer ) = 0;
 
+    // How many clock ticks (starting with the current one) can the CPU run
+    // without this component interrupting it?  Used by the jit engine.
+    // Components that don't know should leave this alone (0 = no promises).
+    virtual int quietTicks( ) const { return 0; }
+
+    // How many clock ticks (starting with the current one) will this
+    // component do nothing but count down and log?  Used by the
+    // event-driven kernel (see skipIdleTicks below), which skips them.
+    // Components that don't know should leave this alone (0 = no promises).
+    virtual int idleTicks( ) const { return 0; }
+
+    // Skip ticks clock ticks (at most idleTicks()), i.e. count down
+    // without logging.
+    virtual void skip( int ticks ) { };
+
+    static const int forever = std::numeric_limits< int >::max();
+
 }; // end class rmmixHardware
 
-class rmmixCPU : public rmmixHardware {
+class rmmixCPU final : public rmmixHardware {
 public:
     // ====================================>>>  The Registers
     const int numberOfRegisters = 32; // see RMMIX presentation
 
-    std::vector< int > registers;
+    // The registers live in register banks, one per job, kept by the OS
+    // (see rmminixOS); registers points to the current job's bank.
+    // A context switch just moves the pointer - nothing is copied.
+    int* registers;
 
     // By the way, it's plural because "register" is a keyword inc C (& C++)
 
@@ -90,23 +115,106 @@ public:
     // (and not 16 or 64 or whatever)
     // but for our purposes here it doesn't really matter.  Trust me.
 
-    // ===================================>>> The Instruction Memory
-    const int instructionMemorySize = 1024;
+    // While waiting for an interrupt, the CPU uses a bank of its own, in
+    // which the program counter is -1 (so no job's registers change).
+    std::vector< int > idleBank;
 
-    std::vector< RMMIXinstruction > instructionMemory;
+    void idle( ) {
+        idleBank[ 0 ] = -1;
+        registers = idleBank.data();
+    }
 
-    // ===================================>>> The Data Memory
-    const int dataMemorySize = 1024; // see RMMIX presentation
+    // ===================================>>> The Instruction Memory
+    // Likewise, every job keeps its own code segment (see rmminixOS), and
+    // the CPU points to the current job's one (nullptr = no program).
+    // Instructions are kept packed (see RMMIXinstruction.h), and unpacked
+    // one at a time, as they are executed.
+    const packedProgram* instructionMemory = nullptr;
 
-    std::vector< int > dataMemory; // size = dataMemorySize
+    // ===================================>>> The Data Memory
+    // (see rmmixMemory.h - the size is set on the command line)
+    const int dataMemorySize;
+
+    sparseMemory dataMemory; // size = dataMemorySize
+
+    // LDW and STW raise FATAL (just like a division by zero) for
+    // addresses outside the data memory
+    bool addressOK( int address ) const {
+        return ( ( 0 <= address ) && ( address < dataMemorySize ) );
+    }
+
+    // ===================================>>> The Verifier
+    // The engines trust the program: its register numbers, its LDWI and
+    // STWI addresses and its branch targets.  So the OS verifies every
+    // program as it loads it (see rmminixOS::load): these must be
+    // registers, in the data memory and in the program, respectively - and
+    // so must the registers which TRAP halt, getw and putw hand to the OS.
+    // Verified programs run unchecked.  In the others, the instructions
+    // which failed run on the checked path (see executeChecked), where
+    // they raise FATAL instead of being executed - a conditional branch
+    // only if it is taken.
+
+    bool registerOK( int r ) const {
+        return ( ( 0 <= r ) && ( r < numberOfRegisters ) );
+    }
+
+    // Returns the addresses of the instructions which fail
+    std::vector< int > verify( const packedProgram& program ) const;
+
+    // Does the instruction at address, in a program of programSize
+    // instructions, pass?  (a, b, c = fields[1-3])
+    bool verify( int opCode, int a, int b, int c,
+                 int address, int programSize ) const;
+
+    // On the checked path: must the instruction raise FATAL, right now?
+    bool raisesFATAL( int opCode, int a, int b, int c,
+                      int address, int programSize ) const;
+
+    // ===================================>>> The Execution Engine
+    // The CPU can run a program in one of two ways:
+    //  o  switchEngine interprets the RMMIXinstructions in instructionMemory
+    //     (see executeInstruction) - the original, and the default.
+    //  o  threadedEngine runs the same program, pre-decoded by the OS
+    //     when it was loaded (see rmmixThreadedCode.h and executeDecoded).
+    //  o  jitEngine is the threadedEngine plus native code for hot blocks
+    //     (see rmmixJIT.h and executeNative).
+    //  o  aotEngine is the threadedEngine plus native code for whole jobs,
+    //     compiled in advance by rmmixaot (see rmmixAOT.h and executeNative).
+    // All engines must behave identically - down to the log file.
+    enum engineType : char { switchEngine, threadedEngine, jitEngine, aotEngine };
+
+    engineType engine = switchEngine;
+
+    // The pre-decoded program (set by the OS, used by all but switchEngine)
+    const decodedProgram* decodedMemory = nullptr;
+
+    // The jobs compiled by rmmixaot (aotEngine only - the OS looks up each
+    // program here when loading it)
+    const aotLibrary* aotJobs = nullptr;
+
+    // Native code (and superinstructions, see rmmixThreadedCode.h) run
+    // several instructions in one clock tick.  The CPU then owes the
+    // simulation the remaining ticks - during which it just writes the log
+    // lines for the instructions already executed, whose addresses were
+    // left in nativeTrace.
+    static const int maxNativeRun = 4096; // instructions per run, at most
+    std::vector< int > nativeTrace;
+    int deferredTicks = 0;
+    int deferredIndex = 0; // in nativeTrace, of the next line to be logged
+
+    // Statistics (see rmmixsim --stats): how many instructions were
+    // executed, and how often the engine had to dispatch to do so.
+    long long instructionsExecuted = 0;
+    long long dispatches           = 0;
 
     // Constructor & Destructor
-    rmmixCPU( int devNum )
+    rmmixCPU( int devNum, int memorySize = sparseMemory::defaultSize )
     : rmmixHardware( devNum ),
-      registers( numberOfRegisters ),
-      instructionMemory( instructionMemorySize ),
-      dataMemory( dataMemorySize )
-    { };
+      idleBank( numberOfRegisters ),
+      dataMemorySize( memorySize ),
+      dataMemory( memorySize ),
+      nativeTrace( maxNativeRun )
+    { idle(); };
     virtual ~rmmixCPU( ) { };
 
     virtual std::ostream& log( ) {
@@ -117,6 +225,24 @@ public:
     // Arithmetical Logic Unit
     void executeInstruction(RMMIXinstruction& instruction);
 
+    // The checked path (see The Verifier, above) - raises FATAL or calls
+    // executeInstruction
+    void executeChecked(RMMIXinstruction& instruction);
+
+    // Same thing for the threadedEngine - executes the instruction
+    // at decodedMemory[ registers[ 0 ] ]
+    void executeDecoded( );
+
+    // Same thing for the jit & aot engines - executes native code from
+    // registers[ 0 ] on, if there is any, else falls back to executeDecoded
+    void executeNative( );
+
+    // Minimum of quietTicks() over all other hardware components
+    int ticksUntilInterrupt( ) const;
+
+    // The CPU is idle (forever) if there's no program and no interrupt
+    virtual int idleTicks( ) const;
+
     // take care of traps (a.k.a. interrupts )
     void handleInterrupt( );
 
@@ -132,11 +258,21 @@ public:
 }; // end rmmixCPU
 
 
-class rmmixInputDevice : public rmmixHardware {
+// The input and output devices take one request (GETW resp. PUTW) at a
+// time through their trapNumber, but hold any number of them: requests
+// which arrive while the device is busy are queued, and served in order
+// (see also rmminixOS::handleSUBMIT - asynchronous I/O).  A request may
+// read resp. write a block of words at once, for the same delay (see
+// rmminixOS::readAheadPolicy and rmminixOS::writeCombiningPolicy).
+class rmmixInputDevice final : public rmmixHardware {
 public:
     objectCodeDecompiler*    decompiler;
     const int                inputDelay = 10; // clock ticks
     int                      countDownTimer = 0;
+    int                      words = 0;   // to read for the request being served
+    std::deque< int >        queued;      // how many words each waiting request wants
+    std::deque< std::vector< int > > received; // the words each request read,
+                                               // until the OS takes them
 
     rmmixInputDevice( int                    devNum,
                       objectCodeDecompiler*  deco = nullptr )
@@ -158,14 +294,29 @@ public:
         decompiler = deco;
     };
 
+    virtual int quietTicks( ) const;
+    virtual int idleTicks( ) const;
+    virtual void skip( int ticks ) {
+        assert( ( 0 == countDownTimer ) || ( ticks < countDownTimer ) );
+        if ( countDownTimer ) countDownTimer -= ticks;
+    };
+
+    // Is there a request (being) served?
+    bool busy( ) const { return trapNumber || countDownTimer || ! queued.empty(); }
+
+    // Forget all requests (and their interrupts, if still pending)
+    void cancel( );
+
 };
 
-class rmmixOutputDevice : public rmmixHardware {
+class rmmixOutputDevice final : public rmmixHardware {
 public:
     std::ostream*    outputSink;
     const int        outputDelay = 10; // clock ticks
     int              countDownTimer = 0;
-    int              buffer;
+    std::vector< int > buffer; // the words being written
+    std::deque< std::vector< int > > queued; // the words of the requests
+                                             // waiting to be served
 
     rmmixOutputDevice( int           devNum,
                       std::ostream*  sink = nullptr )
@@ -187,11 +338,226 @@ public:
         outputSink = sink;
     };
 
+    virtual int quietTicks( ) const;
+    virtual int idleTicks( ) const;
+    virtual void skip( int ticks ) {
+        assert( ( 0 == countDownTimer ) || ( ticks < countDownTimer ) );
+        if ( countDownTimer ) countDownTimer -= ticks;
+    };
+
+    // Is there a request (being) served?
+    bool busy( ) const { return trapNumber || countDownTimer || ! queued.empty(); }
+
+    // Forget all requests (and their interrupts, if still pending)
+    void cancel( );
+
+    // Write the words of all requests right away, and forget the requests
+    // (as cancel) - when there is no one left to wait for them.
+    void finish( );
+
+};
+
+// The timer interrupts the CPU when the current job's time slice (quantum)
+// is over, so that the OS can give the CPU to another job.  The OS programs
+// it like the I/O devices: trapNumber = TIMER, trapData = quantum (in
+// clock ticks) starts counting down anew; a quantum of zero stops it.
+class rmmixTimerDevice final : public rmmixHardware {
+public:
+    int              countDownTimer = 0;
+
+    rmmixTimerDevice( int devNum ) : rmmixHardware( devNum ) { };
+
+    virtual ~rmmixTimerDevice( ) { };
+
+    virtual std::ostream& log( ) {
+        return ( rmmixHardware::log() << "Timer " );
+    };
+    // perform do one clock tick
+    virtual void run( );
+
+    // The timer does not really support the bind method
+    virtual void bind( void *pointer ) {
+        std::cerr << "ERROR: Timer cannot be bound to a pointer" << std::endl;
+        exit( -7 );
+    };
+
+    virtual int quietTicks( ) const;
+    virtual int idleTicks( ) const;
+    virtual void skip( int ticks ) {
+        assert( ( 0 == countDownTimer ) || ( ticks < countDownTimer ) );
+        if ( countDownTimer ) countDownTimer -= ticks;
+    };
+
 };
 
+// The DMA (direct memory access) controller moves whole blocks of words
+// between a job's input (after $RUN) or output and the data memory, and
+// interrupts the CPU just once per block (BLOCK_READY, with the channel
+// as trapData).  It has one channel per job, which the OS programs like
+// the other devices: trapNumber = GETB or PUTB, plus where the block is
+// and where the words come from or go to.  A transfer takes setupDelay
+// ticks, plus one per word - the words are moved in the last one.
+class rmmixDMADevice final : public rmmixHardware {
+public:
+    struct channel {
+        int                   trapNumber = 0; // the request, until started
+        int                   transfer = 0;   // GETB or PUTB, while busy
+        int                   address = 0;    // in the data memory
+        int                   count = 0;      // words
+        objectCodeDecompiler* source = nullptr; // for GETB
+        std::ostream*         sink = nullptr;   // for PUTB
+        int                   countDownTimer = 0;
+    };
+
+    const int              setupDelay = 10; // clock ticks
+    std::vector< channel > channels;        // channels[ i ] belongs to job i
+
+    rmmixDMADevice( int devNum, int numberOfChannels )
+    : rmmixHardware( devNum ), channels( numberOfChannels )
+    { };
+
+    virtual ~rmmixDMADevice( ) { };
+
+    virtual std::ostream& log( ) {
+        return ( rmmixHardware::log() << "DMA " );
+    };
+    // perform do one clock tick
+    virtual void run( );
+
+    // Is the channel requested, or still transferring?
+    bool busy( int ch ) const {
+        return channels[ ch ].trapNumber || channels[ ch ].transfer;
+    };
+
+    // The DMA controller does not really support the bind method
+    virtual void bind( void *pointer ) {
+        std::cerr << "ERROR: DMA controller cannot be bound to a pointer" << std::endl;
+        exit( -7 );
+    };
+
+    virtual int quietTicks( ) const;
+    virtual int idleTicks( ) const;
+    virtual void skip( int ticks );
+
+private:
+    // Moves the words, and signals the CPU
+    void complete( int ch );
+};
+
+// The interrupt controller stands between the devices and the CPU: the
+// devices raise their interrupts here, and they are pending until the CPU
+// is ready for one (i.e. its trapNumber is zero).  Then, once per clock
+// tick (after all devices have run), the most urgent pending interrupt is
+// delivered - the lowest device number has the highest priority, and a
+// device's own interrupts are delivered in the order it raised them.
+// The OS can mask a device: its interrupts stay pending until unmasked.
+class rmmixInterruptController {
+public:
+    // The device raises an interrupt (into the CPU's trap registers, later)
+    void raise( int source, int trapNumber, int trapData, int trapStatus );
+
+    // The device takes back its pending interrupts (e.g. the timer, when
+    // the OS starts a new quantum before the old one's end was delivered)
+    void withdraw( int source );
+
+    // Delivers the most urgent (unmasked) pending interrupt, if the CPU
+    // is ready for it
+    void deliver( rmmixCPU& cpu );
+
+    void mask( int source )   { maskedSources.insert( source ); }
+    void unmask( int source ) { maskedSources.erase( source ); }
+    bool masked( int source ) const { return maskedSources.count( source ); }
+
+    // How many interrupts are pending (masked or not)?
+    int pending( ) const { return int( queue.size() ); }
+
+    void clear( );
+
+    // Statistics (see rmmixsim --stats): how many interrupts were delivered,
+    // and how many clock ticks they were pending (in total, and at most)
+    long long delivered    = 0;
+    long long totalLatency = 0;
+    int       maxLatency   = 0;
+
+private:
+    struct pendingInterrupt {
+        int       source;   // the device number, i.e. the priority
+        long long sequence; // in which order the interrupts were raised
+        int       trapNumber;
+        int       trapData;
+        int       trapStatus;
+        int       raised;   // clock tick
+
+        bool operator<( const pendingInterrupt& other ) const {
+            return ( source < other.source ) ||
+                   ( ( source == other.source ) && ( sequence < other.sequence ) );
+        }
+    };
+
+    std::set< pendingInterrupt > queue; // most urgent first
+    std::set< int >              maskedSources;
+    long long                    raisedSoFar = 0;
+}; // end rmmixInterruptController
+
+// All the hardware, in order of device number: the CPU is device 0, and
+// job i (counting from 0) has input device 2i+1 and output device 2i+2.
+// If the OS needs them, the timer (see addTimer - added at boot) and the
+// DMA controller (see addDMA - added when a job first needs it) come last.
+// The devices are stored by kind, each kind in one contiguous array, and
+// since the device classes are final, run() etc. call them directly
+// (no virtual function calls, no pointer chasing).
+class componentTable {
+public:
+    rmmixCPU*                        cpu = nullptr;
+    std::vector< rmmixInputDevice >  inputs;  // inputs[ i ] is device 2i+1
+    std::vector< rmmixOutputDevice > outputs; // outputs[ i ] is device 2i+2
+    std::vector< rmmixTimerDevice >  timers;  // empty, or just the timer
+    std::vector< rmmixDMADevice >    dmas;    // empty, or just the DMA controller
+    rmmixInterruptController         interrupts; // between the devices and the CPU
+
+    // (Re-) Initializer - the CPU, plus one input and one output per job
+    void setUp( rmmixCPU* theCPU, int numberOfJobs );
+
+    // Adds the timer (if there is none yet), and returns it
+    rmmixTimerDevice* addTimer( );
+
+    // Returns the timer, or nullptr if there is none
+    rmmixTimerDevice* timer( ) {
+        return ( timers.empty() ? nullptr : &timers.front() );
+    }
+
+    // Adds the DMA controller (if there is none yet), and returns it
+    rmmixDMADevice* addDMA( );
+
+    // Returns the DMA controller, or nullptr if there is none
+    rmmixDMADevice* dma( ) {
+        return ( dmas.empty() ? nullptr : &dmas.front() );
+    }
+
+    // Returns the component with the given device number (nullptr if none)
+    rmmixHardware* operator[]( int deviceNumber );
+
+    // One clock tick - runs all components, in order of device number,
+    // then lets the interrupt controller deliver an interrupt
+    void run( );
+
+    // Minimum of quietTicks() over all devices (i.e. all but the CPU)
+    int quietTicks( ) const;
+
+    // Minimum of idleTicks() over all components, resp. skip() all of them
+    int idleTicks( ) const;
+    void skip( int ticks );
+
+}; // end componentTable
+
 // =================== Global Variables!!!
 extern rmmixCPU* theCPU;
-extern std::map< int, rmmixHardware* > hardwareComponents; // global list of hardware
+extern componentTable hardwareComponents; // global list of hardware
+
+// The event-driven kernel (rmmixsim --skip-idle): if all components are
+// idle for the next few clock ticks, skip them (at most limit ticks), i.e.
+// jump the clock straight to the next event.  Returns the ticks skipped.
+int skipIdleTicks( int limit );
 
 
 #endif /* RMMIXHARDWARE_H_ */
@@ -0,0 +1,346 @@
+// =====================================================================
+// rmmixJIT.cpp - Source code for the just-in-time compiler.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Source File for rmmixJIT.h
+// See rmmixJIT.h for more information
+//
+// =====================================================================
+
+#include <cstring> // for std::memcpy
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <sys/mman.h> // for mmap, mprotect, munmap
+#endif
+
+#include "RMMIXcodes.h"
+#include "rmmixThreadedCode.h"
+
+#include "rmmixJIT.h"
+
+namespace {
+
+const std::size_t chunkSize = 64 * 1024; // bytes of executable memory
+
+#if defined(__x86_64__)
+
+// The native code is called as   int block( int* registers, int* dataMemory )
+// i.e. (System V calling convention) registers is in rdi, dataMemory in rsi,
+// and the result is returned in eax.  Only eax and ecx are used otherwise.
+// Register i of the RMMIX CPU is the dword at [rdi + 4*i].
+
+class x86Emitter {
+public:
+    std::vector< unsigned char > code;
+
+    void byte( int b ) { code.push_back( (unsigned char)( b ) ); }
+
+    void dword( int d ) {
+        for ( int i = 0; i < 4; ++i )
+            byte( ( unsigned( d ) >> ( 8 * i ) ) & 0xff );
+    }
+
+    // op reg, [rdi + 4*rmmixRegister]  (modrm: mod = 10, rm = 111)
+    void withRegister( int opByte, int reg, int rmmixRegister ) {
+        byte( opByte );
+        byte( 0x80 | ( reg << 3 ) | 0x7 );
+        dword( 4 * rmmixRegister );
+    }
+
+    // some x86 registers
+    static const int eax = 0;
+    static const int ecx = 1;
+
+    void loadEAX( int r )   { withRegister( 0x8B, eax, r ); } // mov eax,[r]
+    void loadECX( int r )   { withRegister( 0x8B, ecx, r ); } // mov ecx,[r]
+    void storeEAX( int r )  { withRegister( 0x89, eax, r ); } // mov [r],eax
+    void addEAX( int r )    { withRegister( 0x03, eax, r ); } // add eax,[r]
+    void subEAX( int r )    { withRegister( 0x2B, eax, r ); } // sub eax,[r]
+    void imulEAX( int r ) {                                   // imul eax,[r]
+        byte( 0x0F );
+        withRegister( 0xAF, eax, r );
+    }
+
+    void storeImmediate( int r, int value ) {           // mov dword [r],imm
+        withRegister( 0xC7, 0, r );
+        dword( value );
+    }
+    void compareWithZero( int r ) {                     // cmp dword [r],0
+        withRegister( 0x83, 7, r );
+        byte( 0 );
+    }
+
+    void addEAXimmediate( int value ) { byte( 0x05 ); dword( value ); }
+    void subEAXimmediate( int value ) { byte( 0x2D ); dword( value ); }
+    void imulEAXimmediate( int value ) {          // imul eax,eax,imm
+        byte( 0x69 ); byte( 0xC0 ); dword( value );
+    }
+    void movEAXimmediate( int value ) { byte( 0xB8 ); dword( value ); }
+    void movECXimmediate( int value ) { byte( 0xB9 ); dword( value ); }
+    void compareEAXimmediate( int value ) { byte( 0x3D ); dword( value ); }
+    void testECX( )       { byte( 0x85 ); byte( 0xC9 ); }
+    void divideEAXbyECX( ) {                      // cdq; idiv ecx
+        byte( 0x99 ); byte( 0xF7 ); byte( 0xF9 );
+    }
+
+    // data memory, indexed by rax or by an immediate address
+    void loadMemoryEAX( )  { byte( 0x8B ); byte( 0x04 ); byte( 0x86 ); }
+    void storeMemoryECX( ) { byte( 0x89 ); byte( 0x0C ); byte( 0x86 ); }
+    void loadMemoryEAX( int address ) {
+        byte( 0x8B ); byte( 0x86 ); dword( 4 * address );
+    }
+    void storeMemoryEAX( int address ) {
+        byte( 0x89 ); byte( 0x86 ); dword( 4 * address );
+    }
+
+    // conditional jumps - return the position of the rel32 to be patched
+    static const int jumpIfEqual        = 0x84;
+    static const int jumpIfNotEqual     = 0x85;
+    static const int jumpIfAboveOrEqual = 0x83; // unsigned!
+    static const int jumpIfGreaterOrEqual = 0x8D; // signed
+    std::size_t jump( int condition ) {
+        byte( 0x0F ); byte( condition );
+        dword( 0 );
+        return code.size() - 4;
+    }
+    void patch( std::size_t position ) { // jump to here
+        int distance = int( code.size() - ( position + 4 ) );
+        for ( int i = 0; i < 4; ++i )
+            code[ position + i ] = ( unsigned( distance ) >> ( 8 * i ) ) & 0xff;
+    }
+
+    // Leave the block: set the program counter, return the instruction count
+    void leave( int nextAddress, int instructionsExecuted ) {
+        storeImmediate( 0, nextAddress );
+        movEAXimmediate( instructionsExecuted );
+        byte( 0xC3 ); // ret
+    }
+
+}; // end x86Emitter
+
+#endif // defined(__x86_64__)
+
+// Is r an RMMIX register which native code may use?
+// (Not register 0 = the program counter, which the native code does not
+// update instruction by instruction.)
+bool registerOK( int r ) {
+    return ( ( 0 < r ) && ( r < 32 ) );
+}
+
+// (LDWI and STWI address the memory with a 32 bit displacement of
+// 4 * address bytes, which must not overflow - see x86Emitter)
+bool addressOK( int address, int dataMemorySize ) {
+    return ( ( 0 <= address ) && ( address < dataMemorySize )
+             && ( address <= 0x7fffffff / 4 ) );
+}
+
+// Can the instruction be compiled at all?  If not, the block ends
+// just before it.
+bool compilable( const decodedInstruction& in, int dataMemorySize ) {
+    if ( decodedProgram::isChecked( in ) ) // failed verification
+        return false;
+    switch ( in.opCode ) {
+    case RMMIX_JDL::NOP:
+    case RMMIX_JDL::JMPI:
+        return true;
+    case RMMIX_JDL::MOVI:
+    case RMMIX_JDL::BEQZI:
+    case RMMIX_JDL::BNEZI:
+    case RMMIX_JDL::BNEGI:
+        return registerOK( in.a );
+    case RMMIX_JDL::MOV:
+    case RMMIX_JDL::ADDI:
+    case RMMIX_JDL::SUBI:
+    case RMMIX_JDL::MULI:
+    case RMMIX_JDL::LDW:
+    case RMMIX_JDL::STW:
+        return registerOK( in.a ) && registerOK( in.b );
+    case RMMIX_JDL::DIVI: // division by zero raises FATAL - interpreter!
+        return registerOK( in.a ) && registerOK( in.b ) && ( 0 != in.c );
+    case RMMIX_JDL::ADD:
+    case RMMIX_JDL::SUB:
+    case RMMIX_JDL::MUL:
+    case RMMIX_JDL::DIV:
+        return registerOK( in.a ) && registerOK( in.b ) && registerOK( in.c );
+    case RMMIX_JDL::LDWI:
+    case RMMIX_JDL::STWI:
+        return registerOK( in.a ) && addressOK( in.b, dataMemorySize );
+    default: // TRAP, illegal op codes
+        return false;
+    }; // end switch on op code
+} // end compilable
+
+} // end anonymous namespace
+
+jitBlockCache::~jitBlockCache( ) {
+    reset( 0 );
+} // end destructor
+
+void jitBlockCache::reset( int programSize ) {
+#if defined(__x86_64__)
+    for ( auto c : chunks )
+        munmap( c.base, c.size );
+#endif
+    chunks.clear();
+    blocks.assign( programSize, jitBlock() );
+} // end reset
+
+const jitBlock* jitBlockCache::reach( const decodedProgram& program,
+                                      int address, int dataMemorySize ) {
+    jitBlock& block = blocks[ address ];
+    if ( nullptr == block.nativeCode ) {
+        if ( block.compileFailed || ( ++block.timesReached < hotThreshold ) )
+            return nullptr;
+        if ( ! compile( program, address, dataMemorySize, block ) ) {
+            block.compileFailed = true;
+            return nullptr;
+        };
+    }; // end if not yet compiled
+    return ( &block );
+} // end reach
+
+void* jitBlockCache::install( const std::vector< unsigned char >& code ) {
+#if defined(__x86_64__)
+    if ( chunks.empty() || ( chunks.back().size - chunks.back().used < code.size() ) ) {
+        std::size_t size = ( code.size() > chunkSize ) ? code.size() : chunkSize;
+        void* base = mmap( nullptr, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if ( MAP_FAILED == base ) return nullptr;
+        chunks.push_back( chunk{ static_cast< unsigned char* >( base ), size, 0 } );
+    }
+    else if ( 0 != mprotect( chunks.back().base, chunks.back().size,
+                             PROT_READ | PROT_WRITE ) )
+        return nullptr;
+    // A chunk is never writable and executable at once: it is writable
+    // only while code is copied into it, executable the rest of the time
+    chunk& c = chunks.back();
+    unsigned char* destination = c.base + c.used;
+    std::memcpy( destination, code.data(), code.size() );
+    c.used += code.size();
+    if ( 0 != mprotect( c.base, c.size, PROT_READ | PROT_EXEC ) )
+        return nullptr;
+    return destination;
+#else
+    return nullptr;
+#endif
+} // end install
+
+bool jitBlockCache::compile( const decodedProgram& program, int address,
+                             int dataMemorySize, jitBlock& block ) {
+#if defined(__x86_64__)
+    x86Emitter x86;
+    struct pendingExit { std::size_t position; int count; };
+    std::vector< pendingExit > exits; // jumps out of the middle of the block
+
+    int count = 0; // instructions compiled so far
+    bool ended = false; // by a jump
+    for ( int pc = address; ( pc < program.size() ) && ! ended; ++pc, ++count ) {
+        const decodedInstruction& in = program.code[ pc ];
+        if ( ! compilable( in, dataMemorySize ) )
+            break;
+        switch ( in.opCode ) {
+        case RMMIX_JDL::NOP: break;
+
+        case RMMIX_JDL::MOV:
+            x86.loadEAX( in.b ); x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::MOVI:
+            x86.storeImmediate( in.a, in.b ); break;
+        case RMMIX_JDL::ADD:
+            x86.loadEAX( in.b ); x86.addEAX( in.c ); x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::ADDI:
+            x86.loadEAX( in.b ); x86.addEAXimmediate( in.c );
+            x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::SUB:
+            x86.loadEAX( in.b ); x86.subEAX( in.c ); x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::SUBI:
+            x86.loadEAX( in.b ); x86.subEAXimmediate( in.c );
+            x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::MUL:
+            x86.loadEAX( in.b ); x86.imulEAX( in.c ); x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::MULI:
+            x86.loadEAX( in.b ); x86.imulEAXimmediate( in.c );
+            x86.storeEAX( in.a ); break;
+
+        case RMMIX_JDL::DIV: // leave the block if dividing by zero
+            x86.loadECX( in.c ); x86.testECX();
+            exits.push_back( pendingExit{ x86.jump( x86.jumpIfEqual ), count } );
+            x86.loadEAX( in.b ); x86.divideEAXbyECX(); x86.storeEAX( in.a );
+            break;
+        case RMMIX_JDL::DIVI: // (divisor is not zero - see compilable)
+            x86.loadEAX( in.b ); x86.movECXimmediate( in.c );
+            x86.divideEAXbyECX(); x86.storeEAX( in.a ); break;
+
+        case RMMIX_JDL::LDWI:
+            x86.loadMemoryEAX( in.b ); x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::STWI:
+            x86.loadEAX( in.a ); x86.storeMemoryEAX( in.b ); break;
+        case RMMIX_JDL::LDW: // leave the block if the address is bad
+            x86.loadEAX( in.b ); x86.compareEAXimmediate( dataMemorySize );
+            exits.push_back( pendingExit{ x86.jump( x86.jumpIfAboveOrEqual ),
+                                          count } );
+            x86.loadMemoryEAX(); x86.storeEAX( in.a ); break;
+        case RMMIX_JDL::STW:
+            x86.loadEAX( in.b ); x86.compareEAXimmediate( dataMemorySize );
+            exits.push_back( pendingExit{ x86.jump( x86.jumpIfAboveOrEqual ),
+                                          count } );
+            x86.loadECX( in.a ); x86.storeMemoryECX(); break;
+
+            // The jumps end the block
+        case RMMIX_JDL::JMPI:
+            x86.leave( pc + in.a + 1, count + 1 );
+            ended = true;
+            break;
+        case RMMIX_JDL::BEQZI:
+        case RMMIX_JDL::BNEZI:
+        case RMMIX_JDL::BNEGI: {
+            x86.compareWithZero( in.a );
+            int notTaken = ( RMMIX_JDL::BEQZI == in.opCode ) ? x86.jumpIfNotEqual
+                         : ( RMMIX_JDL::BNEZI == in.opCode ) ? x86.jumpIfEqual
+                                                 : x86.jumpIfGreaterOrEqual;
+            std::size_t fallThrough = x86.jump( notTaken );
+            x86.leave( pc + in.b + 1, count + 1 );
+            x86.patch( fallThrough );
+            x86.leave( pc + 1, count + 1 );
+            ended = true;
+            break;
+        }
+        default: break; // cannot happen - see compilable
+        }; // end switch on op code
+    }; // end for all instructions in the block
+
+    if ( 0 == count ) return false; // nothing to compile here
+    if ( ! ended )
+        x86.leave( address + count, count );
+    for ( auto exit : exits ) {
+        x86.patch( exit.position );
+        x86.leave( address + exit.count, exit.count );
+    }; // end for all exits from the middle of the block
+
+    void* nativeCode = install( x86.code );
+    if ( nullptr == nativeCode ) return false;
+    block.nativeCode = reinterpret_cast< jitBlock::nativeCode_type >( nativeCode );
+    block.length = count;
+    return true;
+#else
+    return false; // no compiler for this machine
+#endif
+} // end compile
@@ -0,0 +1,101 @@
+// =====================================================================
+// rmmixJIT.h - Header file for the just-in-time compiler, which translates
+//              frequently executed ("hot") basic blocks into native code.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file rmmixJIT.h
+//
+// A basic block is a run of instructions which ends with a jump
+// (JMPI, BEQZI, BNEZI or BNEGI) or just before a TRAP.  Every time the
+// CPU (with --engine=jit) reaches an instruction, the block starting there
+// is counted; once it has been reached hotThreshold times, it is compiled
+// to x86-64 machine code.  The 32 registers and the data memory stay
+// where they are (in rmmixCPU) - the native code gets pointers to them.
+//
+// Native code never handles an interrupt.  It stops (and leaves the rest
+// to the interpreter) before a TRAP, before a division by zero (which
+// raises FATAL), before touching memory outside the data memory, and
+// before any instruction which uses register 0 (the program counter).
+// Context switches only happen in interrupt handlers, i.e. between blocks.
+//
+// On machines which are not x86-64, nothing is ever compiled, and the jit
+// engine behaves exactly like the threaded engine.
+//
+// =====================================================================
+
+#ifndef RMMIXJIT_H_
+#define RMMIXJIT_H_
+
+#include <cstddef> // for std::size_t
+#include <vector>
+
+class decodedProgram; // see rmmixThreadedCode.h
+
+struct jitBlock {
+    // Native code - returns the number of instructions executed, and
+    // leaves the address of the next instruction in registers[ 0 ].
+    typedef int (*nativeCode_type)( int* registers, int* dataMemory );
+
+    int             timesReached  = 0;
+    bool            compileFailed = false;
+    int             length        = 0; // max. number of instructions executed
+    nativeCode_type nativeCode    = nullptr;
+}; // end jitBlock
+
+class jitBlockCache {
+public:
+    // How often a block must be reached before it is compiled
+    static const int hotThreshold = 16;
+
+    jitBlockCache( ) { };
+    ~jitBlockCache( );
+
+    // The cache owns executable memory - so no copies, please.
+    jitBlockCache( const jitBlockCache& ) = delete;
+    jitBlockCache& operator=( const jitBlockCache& ) = delete;
+
+    // Forget all blocks and release all native code (the program changed)
+    void reset( int programSize );
+
+    // Count that the block starting at address has been reached.
+    // Returns the block if (and only if) it has been compiled, else nullptr.
+    const jitBlock* reach( const decodedProgram& program, int address,
+                           int dataMemorySize );
+
+private:
+    std::vector< jitBlock > blocks; // one per instruction (possible start)
+
+    // Executable memory, allocated in chunks (see install)
+    struct chunk {
+        unsigned char* base;
+        std::size_t    size;
+        std::size_t    used;
+    };
+    std::vector< chunk > chunks;
+
+    bool compile( const decodedProgram& program, int address,
+                  int dataMemorySize, jitBlock& block );
+
+    // copies code into executable memory, returns nullptr if impossible
+    void* install( const std::vector< unsigned char >& code );
+
+}; // end jitBlockCache
+
+#endif /* RMMIXJIT_H_ */
@@ -0,0 +1,76 @@
+// =====================================================================
+// rmmixMemory.cpp - Source Code file for the data memory of the RMMIX
+//                   CPU (see rmmixMemory.h)
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+
+#include <algorithm> // for std::min
+#include <vector>
+
+#include <sys/mman.h> // for mmap, munmap, mincore
+#include <unistd.h>   // for sysconf
+
+#include "rmmixMemory.h"
+
+sparseMemory::sparseMemory( int words )
+: numberOfWords( words )
+{
+    if ( ( words < 1 ) || ( maxSize < words ) )
+        throw std::string( "Bad data memory size " ) + std::to_string( words );
+    // Anonymous memory is zero, and MAP_NORESERVE keeps the operating
+    // system from setting aside memory (or swap) for pages never touched
+    void* reserved = ::mmap( nullptr, std::size_t( words ) * sizeof( int ),
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    if ( MAP_FAILED == reserved )
+        throw std::string( "Cannot reserve " ) + std::to_string( words )
+              + " words of data memory";
+    this->words = static_cast< int* >( reserved );
+} // end constructor
+
+sparseMemory::~sparseMemory( )
+{
+    ::munmap( words, std::size_t( numberOfWords ) * sizeof( int ) );
+} // end destructor
+
+std::size_t sparseMemory::residentBytes( ) const
+{
+    const std::size_t pageSize = std::size_t( ::sysconf( _SC_PAGESIZE ) );
+    const std::size_t bytes = std::size_t( numberOfWords ) * sizeof( int );
+    std::vector< unsigned char > resident( ( bytes + pageSize - 1 ) / pageSize );
+    if ( 0 != ::mincore( words, bytes, resident.data() ) )
+        return 0;
+    std::size_t pages = 0;
+    for ( unsigned char page : resident )
+        pages += ( page & 1 );
+    return pages * pageSize;
+} // end residentBytes
+
+int sparseMemory::parseSize( const std::string& spec )
+{
+    const std::size_t end = std::min( spec.find_first_not_of( "0123456789" ), spec.size() );
+    const std::string unit = spec.substr( end );
+    const int shift = unit.empty() ? 0 : ( "K" == unit ) ? 10
+                      : ( "M" == unit ) ? 20 : ( "G" == unit ) ? 30 : -1;
+    const long long number = ( ( 0 < end ) && ( end <= 10 ) )
+                             ? std::stoll( spec.substr( 0, end ) ) : 0;
+    if ( ( shift < 0 ) || ( number < 1 ) || ( ( maxSize >> shift ) < number ) )
+        throw std::string( "Bad data memory size " ) + spec;
+    return int( number << shift );
+} // end parseSize
@@ -0,0 +1,71 @@
+// =====================================================================
+// rmmixMemory.h - Header file for the data memory of the RMMIX CPU.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file rmmixMemory.h
+//
+// The size of the data memory is set on the command line (see rmmixsim
+// --memory), from one word up to maxSize words (8 GB).  So much memory is
+// only reserved, not allocated: the operating system backs it page by
+// page (4 KB at a time), when a page is first touched.  Memory which is
+// never used costs nothing, and reads as zero, as it always did.
+//
+// The words are still all in one piece, so every engine - native code
+// included - can index the memory like an array.
+//
+// =====================================================================
+
+#ifndef RMMIXMEMORY_H_
+#define RMMIXMEMORY_H_
+
+#include <cstddef> // for std::size_t
+#include <string>
+
+class sparseMemory {
+public:
+    static const int defaultSize = 1024;       // words - see RMMIX presentation
+    static const int maxSize     = 0x7fffffff; // words - addresses are ints
+
+    explicit sparseMemory( int words = defaultSize );
+    ~sparseMemory( );
+
+    sparseMemory( const sparseMemory& ) = delete;
+    sparseMemory& operator=( const sparseMemory& ) = delete;
+
+    int&       operator[]( int address )       { return words[ address ]; }
+    const int& operator[]( int address ) const { return words[ address ]; }
+
+    int*       data( )       { return words; }
+    const int* data( ) const { return words; }
+    int        size( ) const { return numberOfWords; }
+
+    // How many bytes are actually backed by the operating system
+    std::size_t residentBytes( ) const;
+
+    // A size as given on the command line: a number of words, optionally
+    // followed by K, M or G (times 1024, 1024^2, 1024^3).  Throws if bad.
+    static int parseSize( const std::string& spec );
+
+private:
+    int* words;
+    int  numberOfWords;
+}; // end sparseMemory
+
+#endif /* RMMIXMEMORY_H_ */
@@ -0,0 +1,325 @@
+// =====================================================================
+// rmmixThreadedCode.cpp - Source code for pre-decoded (threaded) code.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Source File for rmmixThreadedCode.h
+// See rmmixThreadedCode.h for more information
+//
+// =====================================================================
+
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include "RMMIXcodes.h"
+#include "rmmixHardware.h"
+
+#include "rmmixThreadedCode.h"
+
+// The handlers - one per op code.  Each one does EXACTLY what the
+// corresponding case in rmmixCPU::executeInstruction does, including
+// incrementing the program counter at the end.
+// They live in an anonymous namespace, since only handlerFor() needs them.
+namespace {
+
+typedef decodedInstruction instr_type; // just to keep the lines short
+
+void doNOP( rmmixCPU& cpu, const instr_type& ) {
+    cpu.registers[ 0 ]++;
+}
+
+    // the simple arithmetic instructions
+
+void doMOV( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.registers[ in.b ];
+    cpu.registers[ 0 ]++;
+}
+
+void doMOVI( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = in.b;
+    cpu.registers[ 0 ]++;
+}
+
+void doADD( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] + cpu.registers[ in.c ];
+    cpu.registers[ 0 ]++;
+}
+
+void doADDI( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] + in.c;
+    cpu.registers[ 0 ]++;
+}
+
+void doSUB( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] - cpu.registers[ in.c ];
+    cpu.registers[ 0 ]++;
+}
+
+void doSUBI( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] - in.c;
+    cpu.registers[ 0 ]++;
+}
+
+void doMUL( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] * cpu.registers[ in.c ];
+    cpu.registers[ 0 ]++;
+}
+
+void doMULI( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] * in.c;
+    cpu.registers[ 0 ]++;
+}
+
+    // slightly trickier arithmetic instructions
+
+void doDIV( rmmixCPU& cpu, const instr_type& in ) {
+    if (0 != cpu.registers[ in.c ])
+        cpu.registers[ in.a ] = cpu.registers[ in.b ] / cpu.registers[ in.c ];
+    else { // if division by zero
+        assert( 0 == cpu.trapNumber );
+        cpu.trapNumber = RMMIX_JDL::FATAL;
+        cpu.trapData = 0;
+    };
+    cpu.registers[ 0 ]++;
+}
+
+void doDIVI( rmmixCPU& cpu, const instr_type& in ) {
+    if (0 != in.c)
+        cpu.registers[ in.a ] = cpu.registers[ in.b ] / in.c;
+    else { // if division by zero
+        assert( 0 == cpu.trapNumber );
+        cpu.trapNumber = RMMIX_JDL::FATAL;
+        cpu.trapData = 0;
+    };
+    cpu.registers[ 0 ]++;
+}
+
+    // The (conditional and unconditional) Jump Instructions
+
+void doJMPI( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ 0 ] += in.a;
+    cpu.registers[ 0 ]++;
+}
+
+void doBEQZI( rmmixCPU& cpu, const instr_type& in ) {
+    if (0 == cpu.registers[ in.a ])
+        cpu.registers[ 0 ] += in.b;
+    cpu.registers[ 0 ]++;
+}
+
+void doBNEZI( rmmixCPU& cpu, const instr_type& in ) {
+    if (0 != cpu.registers[ in.a ])
+        cpu.registers[ 0 ] += in.b;
+    cpu.registers[ 0 ]++;
+}
+
+void doBNEGI( rmmixCPU& cpu, const instr_type& in ) {
+    if (0 > cpu.registers[ in.a ])
+        cpu.registers[ 0 ] += in.b;
+    cpu.registers[ 0 ]++;
+}
+
+    // Trigger an interrupt handler!
+
+void doTRAP( rmmixCPU& cpu, const instr_type& in ) {
+    assert( 0 == cpu.trapNumber );
+    cpu.trapNumber = in.a;
+    cpu.trapData   = in.b;
+    cpu.registers[ 0 ]++;
+}
+
+    // Data Memory Operations
+    // WARNING: No Virtual Memory Yet!!!
+
+void doLDWI( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.registers[ in.a ] = cpu.dataMemory[ in.b ];
+    cpu.registers[ 0 ]++;
+}
+
+void doLDW( rmmixCPU& cpu, const instr_type& in ) {
+    if ( cpu.addressOK( cpu.registers[ in.b ] ) )
+        cpu.registers[ in.a ] = cpu.dataMemory[ cpu.registers[ in.b ] ];
+    else { // if outside the data memory
+        assert( 0 == cpu.trapNumber );
+        cpu.trapNumber = RMMIX_JDL::FATAL;
+        cpu.trapData = 0;
+    };
+    cpu.registers[ 0 ]++;
+}
+
+void doSTWI( rmmixCPU& cpu, const instr_type& in ) {
+    cpu.dataMemory[ in.b ] = cpu.registers[ in.a ];
+    cpu.registers[ 0 ]++;
+}
+
+void doSTW( rmmixCPU& cpu, const instr_type& in ) {
+    if ( cpu.addressOK( cpu.registers[ in.b ] ) )
+        cpu.dataMemory[ cpu.registers[ in.b ] ] = cpu.registers[ in.a ];
+    else { // if outside the data memory
+        assert( 0 == cpu.trapNumber );
+        cpu.trapNumber = RMMIX_JDL::FATAL;
+        cpu.trapData = 0;
+    };
+    cpu.registers[ 0 ]++;
+}
+
+    // Superinstructions - each executes two instructions.  The operands of
+    // the second instruction are in the next decodedInstruction.
+    // (The first instruction never writes to register 0 - see fuse().)
+
+void doSUBthenBEQZI( rmmixCPU& cpu, const instr_type& in ) {
+    const instr_type& next = ( &in )[ 1 ];
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] - cpu.registers[ in.c ];
+    if (0 == cpu.registers[ next.a ])
+        cpu.registers[ 0 ] += next.b;
+    cpu.registers[ 0 ] += 2;
+}
+
+void doADDIthenJMPI( rmmixCPU& cpu, const instr_type& in ) {
+    const instr_type& next = ( &in )[ 1 ];
+    cpu.registers[ in.a ] = cpu.registers[ in.b ] + in.c;
+    cpu.registers[ 0 ] += next.a;
+    cpu.registers[ 0 ] += 2;
+}
+
+void doMOVIthenTRAP( rmmixCPU& cpu, const instr_type& in ) {
+    const instr_type& next = ( &in )[ 1 ];
+    cpu.registers[ in.a ] = in.b;
+    assert( 0 == cpu.trapNumber );
+    cpu.trapNumber = next.a;
+    cpu.trapData   = next.b;
+    cpu.registers[ 0 ] += 2;
+}
+
+    // The checked path: instructions which failed verification (see
+    // rmmixCPU::verify) raise FATAL - or run as usual, if they can.
+
+void doChecked( rmmixCPU& cpu, const instr_type& in ) {
+    if ( cpu.raisesFATAL( in.opCode, in.a, in.b, in.c,
+                          cpu.registers[ 0 ], cpu.decodedMemory->size() ) ) {
+        assert( 0 == cpu.trapNumber );
+        cpu.trapNumber = RMMIX_JDL::FATAL;
+        cpu.trapData = 0;
+        cpu.registers[ 0 ]++;
+    }
+    else
+        decodedProgram::handlerFor( in.opCode )( cpu, in );
+}
+
+    // If we ever get here, something's very wrong!
+
+void doIllegal( rmmixCPU&, const instr_type& ) {
+    std::string err("Illegal Op Code ");
+    throw err;
+}
+
+// Indexed by op code - so the order here MUST match opCode_type
+// (see RMMIXcodes.h)!
+const decodedInstruction::handler_type handlers[ RMMIX_JDL::maxOpCode ] = {
+    doNOP,   // NOP   = 0x0
+    doMOV,   // MOV   = 0x1
+    doMOVI,  // MOVI  = 0x2
+    doADD,   // ADD   = 0x3
+    doADDI,  // ADDI  = 0x4
+    doSUB,   // SUB   = 0x5
+    doSUBI,  // SUBI  = 0x6
+    doMUL,   // MUL   = 0x7
+    doMULI,  // MULI  = 0x8
+    doDIV,   // DIV   = 0x9
+    doDIVI,  // DIVI  = 0xa
+    doJMPI,  // JMPI  = 0xb
+    doBEQZI, // BEQZI = 0xc
+    doBNEZI, // BNEZI = 0xd
+    doBNEGI, // BNEGI = 0xe
+    doTRAP,  // TRAP  = 0xf
+    doLDWI,  // LDWI  = 0x10
+    doLDW,   // LDW   = 0x11
+    doSTWI,  // STWI  = 0x12
+    doSTW    // STW   = 0x13
+};
+
+// Which pairs of instructions are fused, and how
+struct fusionRule {
+    int                            first, second; // op codes
+    decodedInstruction::handler_type handler;
+};
+
+const fusionRule fusionRules[] = {
+    { RMMIX_JDL::SUB,  RMMIX_JDL::BEQZI, doSUBthenBEQZI },
+    { RMMIX_JDL::ADDI, RMMIX_JDL::JMPI,  doADDIthenJMPI },
+    { RMMIX_JDL::MOVI, RMMIX_JDL::TRAP,  doMOVIthenTRAP }
+};
+
+} // end anonymous namespace
+
+decodedInstruction::handler_type decodedProgram::handlerFor( int opCode ) {
+    return ( RMMIX_JDL::opCodeOK( opCode ) ? handlers[ opCode ] : doIllegal );
+} // end handlerFor
+
+bool decodedProgram::isChecked( const decodedInstruction& instruction ) {
+    return ( doChecked == instruction.handler );
+} // end isChecked
+
+void decodedProgram::decode( const packedProgram& program ) {
+    clear();
+    code.reserve( program.size() );
+    listing.reserve( program.size() );
+    for ( std::size_t address = 0; address < program.size(); ++address ) {
+        const RMMIXinstruction instruction = program[ address ];
+        decodedInstruction decoded;
+        decoded.handler = handlerFor( instruction.opCode() );
+        decoded.opCode  = instruction.opCode();
+        decoded.a = instruction.fields[1];
+        decoded.b = instruction.fields[2];
+        decoded.c = instruction.fields[3];
+        code.push_back( decoded );
+        listing.push_back( instruction.dump() );
+    }; // end for all instructions in the program
+    for ( int address : program.unverified )
+        code[ address ].handler = doChecked;
+    fuse();
+    jit.reset( size() );
+} // end decode
+
+void decodedProgram::fuse( ) {
+    for ( int pc = 0; pc + 1 < size(); ++pc ) {
+        decodedInstruction& in = code[ pc ];
+        if ( 0 == in.a ) // writes to the program counter - leave it alone
+            continue;
+        if ( isChecked( in ) || isChecked( code[ pc + 1 ] ) )
+            continue;
+        // BEQZI testing the program counter must see it after the first
+        // instruction has moved it on - leave that alone, too
+        if ( ( RMMIX_JDL::BEQZI == code[ pc + 1 ].opCode ) && ( 0 == code[ pc + 1 ].a ) )
+            continue;
+        for ( const fusionRule& rule : fusionRules )
+            if ( ( rule.first == in.opCode )
+                 && ( rule.second == code[ pc + 1 ].opCode ) )
+                in.fusedHandler = rule.handler;
+    }; // end for all pairs of instructions
+} // end fuse
+
+int decodedProgram::numberFused( ) const {
+    int fused = 0;
+    for ( const decodedInstruction& in : code )
+        if ( in.fusedHandler )
+            ++fused;
+    return fused;
+} // end numberFused
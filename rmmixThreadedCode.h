@@ -0,0 +1,125 @@
+// =====================================================================
+// rmmixThreadedCode.h - Header file for pre-decoded (threaded) code,
+//                       an alternative execution engine for the CPU.
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Header file rmmixThreadedCode.h
+//
+// The original engine (rmmixCPU::executeInstruction) copies every
+// instruction out of the instruction memory and then switches on the op
+// code - every single clock tick.  Here, each program is translated ONCE,
+// when it is loaded (see rmminixOS::load), into a "threaded code" stream:
+// every decodedInstruction carries a pointer to the function (the
+// "handler") which executes it, so the CPU just calls the handler.
+// No copying, no switch.
+//
+// Then certain pairs of instructions which assemblers produce all the time
+// are fused into "superinstructions", which the CPU executes with only one
+// dispatch (see fusionRules in rmmixThreadedCode.cpp):
+//      SUB   then BEQZI  (loop exit tests)
+//      ADDI  then JMPI   (loop back edges)
+//      MOVI  then TRAP   (e.g. halt with status)
+// The first instruction of the pair gets a fusedHandler, which executes
+// both; the second instruction stays as it is, so jumping to it still
+// works.  As with native code, the CPU only uses the fusedHandler if no
+// interrupt can arrive before the second instruction's clock tick, and
+// then logs the second instruction on that tick (see rmmixCPU).
+//
+// =====================================================================
+
+#ifndef RMMIXTHREADEDCODE_H_
+#define RMMIXTHREADEDCODE_H_
+
+#include <string>
+#include <vector>
+
+#include "RMMIXinstruction.h"
+#include "rmmixJIT.h" // for the jitBlockCache class
+#include "rmmixAOT.h" // for aotCode_type
+
+class rmmixCPU; // see rmmixHardware.h - we only need pointers & references
+
+// One instruction, ready to run.  The operands are fields[1-3] of the
+// original RMMIXinstruction.  The op code is not needed to run the
+// instruction (that's what the handler is for), only to compile it
+// (see rmmixJIT.h).
+struct decodedInstruction {
+    typedef void (*handler_type)( rmmixCPU& cpu,
+                                  const decodedInstruction& instruction );
+
+    handler_type handler;
+    int          opCode;
+    int          a, b, c;
+
+    // Executes this instruction and the next one (a superinstruction),
+    // or nullptr if this instruction was not fused with the next one.
+    handler_type fusedHandler = nullptr;
+    static const int fusedLength = 2; // instructions per superinstruction
+}; // end decodedInstruction
+
+class decodedProgram {
+public:
+    // The compact stream that is actually executed...
+    std::vector< decodedInstruction > code;
+
+    // ...and, stored separately (so as not to get in the way), the text
+    // which the CPU writes to the log file for each instruction.
+    std::vector< std::string >        listing;
+
+    // Native code for the hot parts of the program (used by the jit engine
+    // only).  It's a cache, so even a const program can change it.
+    mutable jitBlockCache             jit;
+
+    // Native code for the whole program, compiled by rmmixaot (used by the
+    // aot engine only) - or nullptr if the library did not contain it.
+    aotCode_type                      aotCode = nullptr;
+
+    // (Re-) Initializer - translate a complete program
+    void decode( const packedProgram& program );
+
+    void clear( ) {
+        code.clear();
+        listing.clear();
+        jit.reset( 0 );
+        aotCode = nullptr;
+    }
+
+    int size( ) const { return int( code.size() ); }
+
+    // Number of superinstructions (see above) in the program
+    int numberFused( ) const;
+
+    // Returns the handler for a given op code
+    // (illegal op codes get a handler which throws an exception, just
+    // like rmmixCPU::executeInstruction does).
+    static decodedInstruction::handler_type handlerFor( int opCode );
+
+    // Does the instruction run on the checked path?  (Those which failed
+    // verification do - see packedProgram::unverified.  They are never
+    // fused, nor compiled to native code.)
+    static bool isChecked( const decodedInstruction& instruction );
+
+private:
+    // Give the first instruction of each fusable pair its fusedHandler
+    void fuse( );
+
+}; // end decodedProgram
+
+#endif /* RMMIXTHREADEDCODE_H_ */
@@ -0,0 +1,163 @@
+// =====================================================================
+// rmmixaot.cpp - source code for (main() for) the RMMIX ahead-of-time
+// compiler, which translates object files into a shared library of native
+// code, for use with  rmmixsim --aot=LIBRARY
+//
+// This File is part of the RMMIX Assembler/Simulator Package.
+// Version 0.7, October 2014
+//
+// This package has been developed to be used ONLY with the course
+// named "Betriebssysteme" (Operating Systems), given by
+// Prof. Moore.
+//
+// No warranty of any kind is given to anyone.
+// Only students currently enrolled and actively involved in the
+// "Betriebssysteme" course are granted permission to work with this
+// package, but they are given unlimited permission to do as much or
+// as little with this package as they choose, up to but not including
+// distribution of the package or any of its contents.
+//
+// Please report bugs to <ronald.moore@h-da.de>
+//
+// =====================================================================
+//
+// Source File for the rmmixaot compiler.  See printUsage() for more
+// information on how to use it, and rmmixAOT.h for how it works.
+//
+// =====================================================================
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib> // for std::system, std::getenv
+#include <cstdio>  // for std::remove
+
+#include "RMMIXJobLang.h"
+#include "rmmixAOT.h"
+
+void printVersion() {
+    std::cout << std::endl << "% RMMIX AOT Compiler Version 0.7"
+              << std::endl << std::endl;
+} // end printVersion
+
+void printUsage(const std::string &argv0) {
+    printVersion();
+    std::cerr <<
+            "Usage: " << argv0 << " [OPTION]... -o LIBRARY [FILE]... \n"
+            "Translate all jobs in the RMMIX Object Format FILE(s) into native\n"
+            "code, in the shared library LIBRARY, to be used with\n"
+            "   rmmixsim --aot=LIBRARY FILE...\n"
+            "Options:\n"
+            "\n"
+            "  -o LIBRARY            name of the library to write (e.g. jobs.so)\n"
+            "      --cxx=COMPILER    C++ compiler to use (default: $CXX, or c++)\n"
+            "      --source-only     write the C++ source code to LIBRARY,\n"
+            "                        do not compile it\n"
+            "      --help            display this help and exit\n"
+            "      --version         output version information and exit\n"
+            "\n"
+            "There must be at least one FILE\n"
+            "\n"
+            "Report bugs to <ronald.moore@h-da.de>.\n"
+            "\n";
+} // end printUsage
+
+// Read all jobs (i.e. their code, not their input) from one object file
+bool readJobs( const std::string& filename, aotTranslator& translator ) {
+    objectCodeDecompiler decompiler( filename.c_str() );
+    if ( ! decompiler.good() ) {
+        std::cerr << "Error opening file <" << filename << ">." << std::endl;
+        return false;
+    };
+    try {
+        while ( decompiler.gotoState( JobLangCompiler::codeReaderState ) ) {
+            std::vector< RMMIXinstruction > program;
+            RMMIXinstruction instruction;
+            while ( decompiler >> instruction )
+                program.push_back( instruction );
+            translator.addJob( decompiler.jobname, program );
+            if ( ! decompiler.gotoState( JobLangCompiler::inputReaderState ) )
+                break; // no more input, so no more jobs
+        }; // end while there are jobs
+    } catch ( std::string error ) {
+        std::cerr << "Error while reading file named " << filename
+                  << std::endl << error << std::endl;
+        return false;
+    };
+    return true;
+} // end readJobs
+
+// A path as one word for the shell: in single quotes, inside which only
+// a single quote needs escaping (it becomes '\'')
+std::string shellQuoted( const std::string& path ) {
+    std::string quoted = "'";
+    for ( char c : path )
+        if ( '\'' == c )
+            quoted += "'\\''";
+        else
+            quoted += c;
+    return quoted + "'";
+} // end shellQuoted
+
+int main(int argc, char *argv[]) {
+
+    std::string library;
+    std::string compiler = ( std::getenv( "CXX" ) ? std::getenv( "CXX" ) : "c++" );
+    bool sourceOnly = false;
+    aotTranslator translator;
+
+    for (int argnum = 1; argnum < argc; argnum++) {
+        std::string arg(argv[ argnum ]);
+        if (arg == "--version") {
+            printVersion();
+            return 0;
+        }
+        else if (arg == "--help") {
+            printUsage(argv[ 0 ]);
+            return 0;
+        }
+        else if (arg == "-o" && argnum + 1 < argc)
+            library = argv[ ++argnum ];
+        else if (0 == arg.compare(0, 6, "--cxx="))
+            compiler = arg.substr( 6 );
+        else if (arg == "--source-only")
+            sourceOnly = true;
+        else if (0 == arg.compare(0, 1, "-")) { // unknown option
+            std::cerr << "Unknown option " << arg << std::endl;
+            printUsage(argv[ 0 ]);
+            return -1;
+        }
+        else if ( ! readJobs( arg, translator ) )
+            return -2;
+    }; // end for all arguments
+
+    if ( library.empty() || ( 0 == translator.numberOfJobs() ) ) {
+        printUsage(argv[ 0 ]);
+        return -1;
+    };
+
+    const std::string source = ( sourceOnly ? library : library + ".cpp" );
+    {
+        std::ofstream out( source );
+        translator.write( out );
+        if ( ! out.good() ) {
+            std::cerr << "Error writing file <" << source << ">." << std::endl;
+            return -3;
+        };
+    } // closes out
+    if ( sourceOnly ) return 0;
+
+    // (the compiler is left as it is, so that e.g. CXX="ccache g++" works)
+    const std::string command = compiler + " -O2 -fwrapv -shared -fPIC -o "
+                              + shellQuoted( library ) + " " + shellQuoted( source );
+    const int status = std::system( command.c_str() );
+    std::remove( source.c_str() );
+    if ( 0 != status ) {
+        std::cerr << "Error compiling <" << library << ">: " << command
+                  << std::endl;
+        return -4;
+    };
+    return 0;
+
+} // end main (for rmmixaot)
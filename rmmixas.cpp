@@ -33,9 +33,19 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <algorithm>          // for std::max
+#include <atomic>             // (for --parallel)
+#include <condition_variable>
+#include <cctype>             // for std::isdigit
+#include <cstdlib>            // for std::strtoul
+#include <cstring>            // for std::memchr
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
 #include "RMMIXJobLang.h"
+#include "RMMIXbinaryObject.h"
 
 void printVersion() {
     std::cout << std::endl << "% RMMIX Assembler Version 0.6" 
@@ -52,8 +62,16 @@ void printUsage(const std::string &argv0) {
             "\n"
             "      --help     display this help and exit\n"
             "      --version  output version information and exit\n"
+            "      --binary   write the RMMIX Binary Object Format instead, which\n"
+            "                 the simulator maps into memory instead of parsing it\n"
+            "                 (all FILEs, in one header - so redirect to a file)\n"
+            "      --symbols  with --binary: also write each job's labels\n"
+            "      --parallel[=N]\n"
+            "                 assemble the FILEs, and the jobs in each FILE, with\n"
+            "                 N threads (default: one per core) - the output is\n"
+            "                 the same, in the same order\n"
             "\n"
-            "There must be at least one FILE\n"
+            "There must be at least one FILE - FILE may be - (standard input)\n"
             "\n"
             "Report bugs to <ronald.moore@h-da.de>.\n"
             "\n";
@@ -74,13 +92,305 @@ std::ostream& printInstruction( const RMMIXinstruction& instruction,
     return ostream;
 }
 
+// Assembles the jobs in compiler's file, writing the object code to out
+// (or adding it to writer, with --binary) and the error messages to err.
+// If sectionEnd is not negative, stops when the job starting at lastJob
+// is done (i.e. at sectionEnd) - unless a job had to read past sectionEnd
+// (e.g. because its $RUN or $END is missing), in which case the rest of
+// the file is assembled, just as if there were no sections.  Returns true
+// if the whole rest of the file was assembled.
+bool assembleJobs( assemblyCompiler& compiler, std::ostream& out,
+                   std::ostream& err, RMMIX_JDL::binaryObjectWriter* writer,
+                   std::streamoff lastJob = -1, std::streamoff sectionEnd = -1 ) {
+    bool notFinished = true;
+    while ( notFinished ) {
+        notFinished = compiler.gotoState( JobLangCompiler::codeReaderState );
+        if (notFinished) {
+            if ( writer )
+                writer->addJob( compiler.jobname );
+            else
+                out << "$JOB " << compiler.jobname << std::endl;
+
+            RMMIXinstruction instruction;
+            while ( notFinished ) {
+                try {
+                    notFinished = ( compiler >> instruction );
+                    if ( notFinished && writer )
+                        writer->addInstruction( instruction );
+                    else if ( notFinished )
+                        printInstruction( instruction, out ) << std::endl;
+                } catch ( std::string exception ) {
+                    err << exception << std::endl;
+                };
+            }; // end while notFinished
+            if ( writer )
+                writer->addSymbols( compiler.jumpTable );
+
+            if ( compiler.good() )
+                notFinished = compiler.gotoState( 
+                        JobLangCompiler::inputReaderState );
+            if ( notFinished ) {
+                if ( writer )
+                    writer->startInput( );
+                else
+                    out << "$RUN" << std::endl;
+
+                int inputNumber;
+                while ( notFinished ) {
+                    try {
+                        notFinished = ( compiler >> inputNumber );
+                        if ( notFinished && writer )
+                            writer->addInput( inputNumber );
+                        else if ( notFinished )
+                            printNumber( inputNumber, out ) << std::endl;
+                    } catch ( std::string exception ) {
+                        err << exception << std::endl;
+                    };
+                }; // end while notFinished
+
+                notFinished = compiler.good() && ! compiler.eof();
+                if ( notFinished && ! writer ) 
+                    out << "$END" << std::endl;
+            }; // end if notFinished
+        }; // end if notFinished
+
+        if ( ( 0 <= sectionEnd ) && notFinished ) {
+            std::streamoff position = compiler.inStream.tellg();
+            if ( ( 0 <= position ) && ( position <= sectionEnd ) ) {
+                // Another $JOB ahead, or (after an error) in the current line?
+                if ( ( position <= lastJob ) || compiler.isJobControl( "$JOB" ) )
+                    continue; // with the next job in the section
+                return false; // the next $JOB is left for somebody else
+            };
+            sectionEnd = -1; // read too far - go on to the end of the file
+        };
+    }; // end while notFinished
+    return true;
+} // end assembleJobs
+
+// One part of a file: the whole file, or (with --parallel) one of the
+// sections the file was split into - one or more jobs (see splitFile)
+struct fileSection {
+    std::string    arg;               // the file name, as given
+    std::streamoff begin = 0;         // where the section's first $JOB starts
+    std::streamoff lastJob = -1;      // where its last $JOB starts
+    std::streamoff end = -1;          // where the next section starts (-1: none)
+    int            linesBefore = 0;   // for the line numbers in error messages
+};
+
+// Assembles the section (see assembleJobs), returns true if the whole rest
+// of the file was assembled
+bool assembleFile( const fileSection& section, std::ostream& out,
+                   std::ostream& err, RMMIX_JDL::binaryObjectWriter* writer ) {
+    const std::string& arg = section.arg;
+    // std::cerr << "Opening file " << arg << "  ..." << std::endl;
+    assemblyCompiler compiler( ( arg == "-" ) ? "/dev/stdin" : arg.c_str() );
+    compiler.messages = &err;
+    if ( ! compiler.good() )
+        err << "Error opening file <" << arg << ">." << std::endl;
+    else if ( compiler.eof() )
+        err << "File <" << arg << "> is empty." << std::endl;
+    else { // if compiler object is OK
+        if ( 0 < section.begin ) {
+            compiler.inStream.seekg( section.begin );
+            compiler.lineNumber = section.linesBefore;
+        };
+        return assembleJobs( compiler, out, err, writer,
+                             section.lastJob, section.end );
+    }; // end if compiler object is ok
+    return true;
+} // end assembleFile
+
+// ============================================================ --parallel
+// With --parallel, each file is split at its $JOB lines into sections,
+// which a pool of threads assembles into buffers (one per section).
+// Small jobs are grouped, so that each section is worth a thread's while.
+// main's thread writes the buffers to stdout and stderr in the original
+// order, so the output is the same as without --parallel, byte for byte.
+
+// --parallel=N asks for at most this many threads (and never gets more
+// than there are sections)
+const unsigned long maxThreads = 256;
+
+bool isParallelOption( const std::string& arg ) {
+    return ( arg == "--parallel" ) || ( 0 == arg.compare( 0, 11, "--parallel=" ) );
+} // end isParallelOption
+
+// Everything else is a file name (even if it starts with --)
+bool isOption( const std::string& arg ) {
+    return (arg == "--version") || (arg == "--help") || (arg == "--binary")
+           || (arg == "--symbols") || isParallelOption( arg );
+} // end isOption
+
+const std::streamoff minimumSection = 16 * 1024; // bytes, unless the file ends
+
+// Appends the sections of the file named arg to sections - or the whole
+// file, if it cannot be mapped (e.g. standard input, or a file that does
+// not exist - the assembler then reports the error, as usual)
+void splitFile( const std::string& arg, std::vector< fileSection >& sections ) {
+    fileSection section;
+    section.arg = arg;
+    if ( arg == "-" ) {
+        sections.push_back( section );
+        return;
+    };
+    try {
+        RMMIX_JDL::mappedFile file( arg.c_str() );
+        RMMIX_JDL::lineLexer lexer; // finds the $JOB lines, as the compiler does
+        std::size_t first = sections.size();
+        for ( const char* line = file.begin(); line < file.end(); ) {
+            const char* newline = static_cast< const char* >( 
+                std::memchr( line, '\n', file.end() - line ) );
+            const char* lineEnd = newline ? newline : file.end();
+            std::streamoff offset = line - file.begin();
+            if ( ! ( lexer.scan( line, lineEnd ) && lexer.isKeyword( "$JOB" ) ) )
+                ; // nothing to do
+            else if ( ( first < sections.size() )
+                      && ( offset - sections.back().begin < minimumSection ) )
+                sections.back().lastJob = offset; // the section grows
+            else {
+                if ( first < sections.size() )
+                    sections.back().end = offset;
+                section.begin = section.lastJob = offset;
+                sections.push_back( section );
+            };
+            ++section.linesBefore;
+            line = lineEnd + 1;
+        }; // end for all lines
+        // (no $JOB, no section - there is nothing to assemble)
+    } catch ( std::string cannotMap ) {
+        sections.push_back( section );
+    };
+} // end splitFile
+
+struct assembledSection {
+    std::string out;
+    std::string err;
+    RMMIX_JDL::binaryObjectWriter writer;
+    bool restOfFile = false;   // see assembleJobs
+    bool fatal = false;        // if so, err ends with the fatal error
+    std::string fatalError;
+    bool done = false;         // protected by the mutex, see below
+};
+
+void assembleSection( const fileSection& section, assembledSection& result,
+                      bool binary, bool symbols ) {
+    std::ostringstream out, err;
+    RMMIX_JDL::binaryObjectWriter writer( symbols );
+    try {
+        result.restOfFile = assembleFile( section, out, err,
+                                          binary ? &writer : nullptr );
+    } catch ( std::string exception ) {
+        result.fatal = true;
+        result.fatalError = exception;
+    };
+    result.out = out.str();
+    result.err = err.str();
+    result.writer = std::move( writer );
+} // end assembleSection
+
+// Assembles the files in argv with threads threads - throws the first
+// fatal error (as a std::string), after writing everything before it
+void assembleInParallel( int argc, char *argv[], unsigned threads,
+                         RMMIX_JDL::binaryObjectWriter& writer,
+                         bool binary, bool symbols ) {
+    std::vector< fileSection > sections;
+    std::vector< std::size_t > firstSection( argc + 1 ); // for each argument
+    for (int argnum = 1; argnum < argc; argnum++) {
+        std::string arg( argv[ argnum ] );
+        firstSection[ argnum ] = sections.size();
+        if ( ! isOption( arg ) )
+            splitFile( arg, sections );
+    };
+    firstSection[ argc ] = sections.size();
+
+    std::vector< assembledSection > results( sections.size() );
+    std::atomic< std::size_t > next( 0 ); // the next section to assemble
+    std::mutex mutex;
+    std::condition_variable finished;
+    auto work = [ & ]( ) {
+        for ( std::size_t s = next++; s < sections.size(); s = next++ ) {
+            assembleSection( sections[ s ], results[ s ], binary, symbols );
+            std::lock_guard< std::mutex > lock( mutex );
+            results[ s ].done = true;
+            finished.notify_all();
+        };
+    };
+    std::vector< std::thread > pool;
+    threads = unsigned( std::min( std::size_t( threads ), sections.size() ) );
+    for ( unsigned thread = 0; thread < threads; ++thread )
+        pool.emplace_back( work );
+    auto stop = [ & ]( ) { // skip the sections not yet started, and wait
+        next = sections.size();
+        for ( std::thread& thread : pool )
+            thread.join();
+    };
+
+    for (int argnum = 1; argnum < argc; argnum++) {
+        std::string arg( argv[ argnum ] );
+        if (arg == "--version")
+            printVersion();
+        else if (arg == "--help")
+            printUsage(argv[ 0 ]);
+        for ( std::size_t s = firstSection[ argnum ];
+              s < firstSection[ argnum + 1 ]; ++s ) {
+            assembledSection& result = results[ s ];
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                finished.wait( lock, [ &result ]( ) { return result.done; } );
+            }
+            std::cout << result.out;
+            std::cerr << result.err;
+            if ( result.fatal ) {
+                stop( );
+                throw result.fatalError;
+            };
+            if ( binary )
+                writer.append( std::move( result.writer ) );
+            if ( result.restOfFile )
+                break; // the file's remaining sections were assembled, too
+            result = assembledSection( ); // free the buffers
+        }; // end for all sections of the file
+    }; // end for all arguments
+    stop( );
+} // end assembleInParallel
+
 int main(int argc, char *argv[]) {
 
     try {
+        // --binary, --symbols and --parallel apply to all the files,
+        // wherever they are
+        bool binary = false;
+        bool symbols = false;
+        unsigned threads = 0; // i.e. not in parallel
+        for (int argnum = 1; argnum < argc; argnum++) {
+            std::string arg( argv[ argnum ] );
+            binary  = binary  || ( arg == "--binary" );
+            symbols = symbols || ( arg == "--symbols" );
+            if ( arg == "--parallel" )
+                threads = std::max( 1u, std::thread::hardware_concurrency() );
+            else if ( isParallelOption( arg ) ) {
+                const char* number = arg.c_str() + 11;
+                char* end = nullptr;
+                const unsigned long n = std::isdigit( (unsigned char)( *number ) )
+                                        ? std::strtoul( number, &end, 10 ) : 0;
+                threads = ( ( 0 < n ) && ( n <= maxThreads ) && ( '\0' == *end ) )
+                          ? unsigned( n ) : 0;
+                if ( 0 == threads ) {
+                    std::cerr << "Bad option " << arg << std::endl;
+                    printUsage(argv[ 0 ]);
+                    return -1;
+                };
+            };
+        };
+        RMMIX_JDL::binaryObjectWriter writer( symbols );
+
         // argc == 1 means no arguments
         // (because argv[0] is the name of the program)
         if (argc == 1)
             printUsage(argv[ 0 ]);
+        else if ( 0 < threads )
+            assembleInParallel( argc, argv, threads, writer, binary, symbols );
         else
             for (int argnum = 1; argnum < argc; argnum++) {
                 std::string arg(argv[ argnum ]);
@@ -88,67 +398,20 @@ int main(int argc, char *argv[]) {
                     printVersion();
                 else if (arg == "--help")
                     printUsage(argv[ 0 ]);
-                else // argument is not an option, should be a file name
-                {
-                    // std::cerr << "Opening file " << arg << "  ..." << std::endl;
-                    assemblyCompiler compiler( arg.c_str() );
-                    if ( ! compiler.good() )
-                        std::cerr << "Error opening file <" << arg
-                                  << ">." << std::endl;
-                    else if ( compiler.eof() )
-                        std::cerr << "File <" << arg
-                                  << "> is empty." << std::endl;
-                    else { // if compiler object is OK
-                        bool notFinished = true;
-                        while ( notFinished ) {
-                            notFinished = compiler.gotoState( 
-                                             JobLangCompiler::codeReaderState );
-                            if (notFinished) {
-                                std::cout << "$JOB " << compiler.jobname 
-                                          << std::endl;
-                        
-                               RMMIXinstruction instruction;
-                               while ( notFinished ) {
-                                   try {
-                                       notFinished = ( compiler >> instruction );
-                                        if ( notFinished )
-                                            printInstruction( instruction, 
-                                                              std::cout )
-                                                << std::endl;
-                                   } catch ( std::string exception ) {
-                                       std::cerr << exception << std::endl;
-                                   };
-                                }; // end while notFinished
-
-                                if ( compiler.good() )
-                                    notFinished = compiler.gotoState( 
-                                            JobLangCompiler::inputReaderState );
-                                if ( notFinished ) {
-                                    std::cout << "$RUN" << std::endl;
-
-                                    int inputNumber;
-                                    while ( notFinished ) {
-                                        try {
-                                            notFinished = 
-                                                    ( compiler >> inputNumber );
-                                            if ( notFinished )
-                                                printNumber( inputNumber, 
-                                                                     std::cout )
-                                                << std::endl;
-                                        } catch ( std::string exception ) {
-                                            std::cerr << exception << std::endl;
-                                        };
-                                    }; // end while notFinished
-
-                                    notFinished = compiler.good() && ! compiler.eof();
-                                    if ( notFinished ) 
-                                        std::cout << "$END" << std::endl;
-                                }; // end if notFinished
-                            }; // end if notFinished
-                        }; // end while notFinished
-                    }; // end if compiler object is ok
-                }; // end if argument is not an option, should be a file name
+                else if ((arg == "--binary") || (arg == "--symbols")
+                         || isParallelOption( arg ))
+                    ; // see above
+                else { // argument is not an option, should be a file name
+                    fileSection wholeFile;
+                    wholeFile.arg = arg;
+                    assembleFile( wholeFile, std::cout, std::cerr,
+                                  binary ? &writer : nullptr );
+                };
             }; // end for all arguments
+        if ( binary && ! writer.write( std::cout ) ) {
+            std::cerr << "Error writing binary object format" << std::endl;
+            return -5;
+        };
     } catch (std::string err) {
         std::cerr << "FATAL ERROR " << err << std::endl
                   << "Exiting..." << std::endl;
@@ -35,6 +35,8 @@
 #include <string>
 #include <sstream>
 #include <cassert>
+#include <vector>
+#include <cstdlib> // for std::atexit
 
 #include "rmmixHardware.h"  // for the hardware models (simulator)
 #include "rmminixos.h"      // for the rmminix operating system (simulator)
@@ -55,40 +57,89 @@ void printUsage(const std::string &argv0) {
             "\n"
             "      --help     display this help and exit\n"
             "      --version  output version information and exit\n"
+            "      --engine=switch    interpret instructions one by one (default)\n"
+            "      --engine=threaded  run programs pre-decoded at load time\n"
+            "      --engine=jit       like threaded, but compile hot code to\n"
+            "                         native code (x86-64 only)\n"
+            "      --aot=LIBRARY      like threaded, but run the jobs compiled\n"
+            "                         into LIBRARY by rmmixaot as native code\n"
+            "      --stats            when done, print how many instructions\n"
+            "                         were executed, in how many dispatches,\n"
+            "                         how long interrupts were pending and\n"
+            "                         how long written words were buffered,\n"
+            "                         to stderr\n"
+            "      --skip-idle        while the CPU is idle, skip the clock ticks\n"
+            "                         in which the devices only count down (these\n"
+            "                         ticks are not logged, the results are the same)\n"
+            "      --sched=POLICY     how the jobs share the CPU - POLICY is one of\n"
+            "                         rr[:Q]    round robin, time slices of Q ticks\n"
+            "                                   (default 10; rr:0, the default policy,\n"
+            "                                   switches jobs only when they block)\n"
+            "                         priority  the first job named goes first\n"
+            "                         mlfq[:Q]  multi-level feedback queue, time\n"
+            "                                   slices Q, 2Q, 4Q (default Q = 5)\n"
+            "                         srt       shortest remaining time first\n"
+            "      --output=buffered  collect each job's output in a large buffer,\n"
+            "                         written to its file when full or when the\n"
+            "                         job halts (default)\n"
+            "      --output=mmap      write each job's output straight into its\n"
+            "                         file, mapped into memory\n"
+            "      --memory=WORDS[K|M|G]\n"
+            "                         the size of the data memory, in words (times\n"
+            "                         1024, 1024^2 or 1024^3), at most 2147483647\n"
+            "                         (default 1024) - only the pages the jobs use\n"
+            "                         take up memory\n"
+            "      --readahead=DEPTH[:BURST]\n"
+            "                         keep up to DEPTH words of each job's input\n"
+            "                         ready for its GETWs, read BURST words at a\n"
+            "                         time (default DEPTH/2) - no read-ahead by\n"
+            "                         default\n"
+            "      --combine=SIZE[:LIMIT]\n"
+            "                         collect the words of each job's PUTWs, and\n"
+            "                         write SIZE of them at a time - the job waits\n"
+            "                         only when LIMIT words (default 2*SIZE) are\n"
+            "                         not written yet - no write-combining by\n"
+            "                         default\n"
             "\n"
             "Report bugs to <ronald.moore@h-da.de>.\n"
             "\n";
 } // end printUsage
 
-void SetUpHardware( int argc ) {
+// Called at exit (the OS ends the simulation by calling exit)
+void printStatistics( ) {
+    std::cerr << "% " << theCPU->instructionsExecuted << " instructions in "
+              << theCPU->dispatches << " dispatches" << std::endl;
+    const rmmixInterruptController& interrupts = hardwareComponents.interrupts;
+    std::cerr << "% " << interrupts.delivered << " interrupts, pending for "
+              << ( interrupts.delivered
+                   ? double( interrupts.totalLatency ) / interrupts.delivered : 0.0 )
+              << " ticks on average, " << interrupts.maxLatency << " at most"
+              << std::endl;
+    std::cerr << "% " << theCPU->dataMemorySize << " words of data memory, "
+              << theCPU->dataMemory.residentBytes() / 1024 << " KB of them in use"
+              << std::endl;
+    const rmminixOS::writeBackStatistics& writeBacks = rmminixOS::writeBackStats();
+    if ( writeBacks.blocks )
+        std::cerr << "% " << writeBacks.words << " words written back in "
+                  << writeBacks.blocks << " blocks, after "
+                  << double( writeBacks.totalLatency ) / writeBacks.blocks
+                  << " ticks on average, " << writeBacks.maxLatency << " at most"
+                  << std::endl;
+} // end printStatistics
+
+void SetUpHardware( int argc, int memorySize ) {
 
     // Preliminaries
     rmmixHardware::logStream.open( "rmmix.log" );
     assert ( rmmixHardware::logStream.good() );
 
     // Set up CPU
-    theCPU = new rmmixCPU( 0 ); // devince number zero
+    theCPU = new rmmixCPU( 0, memorySize ); // devince number zero
     assert( theCPU );
-    hardwareComponents[0] = theCPU;
-
-    // NOTE: This code is written to allow multiple input files
-    // BUT THIS HAS NOT BEEN TESTED YET!
-    for ( int arg = 1; arg < argc; arg++ ) { // for all args, except for 0
-
-        int outputDeviceNumber = 2 * arg;
-        int inputDeviceNumber  = outputDeviceNumber -1;
-
-        // Set up input device
-        rmmixInputDevice* inputer = new rmmixInputDevice( inputDeviceNumber );
-        assert( inputer ); // is not null
-        hardwareComponents[ inputDeviceNumber ] = inputer;
-
-        // Set up output Device
-        rmmixOutputDevice* outputer = new rmmixOutputDevice( outputDeviceNumber );
-        assert( outputer ); // is not null
-        hardwareComponents[ outputDeviceNumber ] = outputer;
 
-    }; // end for all arguments on the command line,
+    // ...and one input and one output device per job (i.e. per argument,
+    // except for 0)
+    hardwareComponents.setUp( theCPU, argc - 1 );
 
 } // end SetUpHardware
 
@@ -98,7 +149,20 @@ int main(int argc, char *argv[])
     try {
 
         // take care of any options on the command line (--help, etc)
+        // Everything else should be a file name - these are collected in
+        // fileArgs, which then looks just like argv (without the options).
         bool specialArgsFound = false; // until found
+        rmmixCPU::engineType engine = rmmixCPU::switchEngine;
+        aotLibrary aotJobs; // only used with --aot
+        bool printStats = false;
+        bool skipIdle = false;
+        int memorySize = sparseMemory::defaultSize; // words
+        std::string schedulingPolicy; // default: see rmminixScheduler.h
+        std::string readAheadPolicy;  // default: none, see rmminixos.h
+        std::string writeCombiningPolicy; // default: none, see rmminixos.h
+        rmminixOS::outputChannel::writerType outputWriter =
+            rmminixOS::outputChannel::bufferedWriter;
+        std::vector< char* > fileArgs{ argv[ 0 ] };
         for (int argnum = 1; argnum < argc; argnum++) {
             std::string arg(argv[ argnum ]);
             if (arg == "--version") {
@@ -108,33 +172,77 @@ int main(int argc, char *argv[])
             else if (arg == "--help") {
                 specialArgsFound = true;
                 printUsage(argv[ 0 ]);
-            }; // else, hopefully it's a file name
+            }
+            else if (arg == "--engine=switch")
+                engine = rmmixCPU::switchEngine;
+            else if (arg == "--engine=threaded")
+                engine = rmmixCPU::threadedEngine;
+            else if (arg == "--engine=jit")
+                engine = rmmixCPU::jitEngine;
+            else if (arg == "--stats")
+                printStats = true;
+            else if (arg == "--skip-idle")
+                skipIdle = true;
+            else if (0 == arg.compare(0, 8, "--sched="))
+                schedulingPolicy = arg.substr( 8 );
+            else if (0 == arg.compare(0, 9, "--memory="))
+                memorySize = sparseMemory::parseSize( arg.substr( 9 ) );
+            else if (0 == arg.compare(0, 12, "--readahead="))
+                readAheadPolicy = arg.substr( 12 );
+            else if (0 == arg.compare(0, 10, "--combine="))
+                writeCombiningPolicy = arg.substr( 10 );
+            else if (arg == "--output=buffered")
+                outputWriter = rmminixOS::outputChannel::bufferedWriter;
+            else if (arg == "--output=mmap")
+                outputWriter = rmminixOS::outputChannel::mappedWriter;
+            else if (0 == arg.compare(0, 6, "--aot=")) {
+                if ( ! aotJobs.open( arg.substr( 6 ) ) ) {
+                    std::cerr << "Cannot use " << arg << ": " << aotJobs.error
+                              << std::endl;
+                    return ( -1 );
+                };
+                engine = rmmixCPU::aotEngine;
+            }
+            else if (0 == arg.compare(0, 2, "--")) { // unknown option
+                std::cerr << "Unknown option " << arg << std::endl;
+                printUsage(argv[ 0 ]);
+                return ( -1 );
+            }
+            else // hopefully it's a file name
+                fileArgs.push_back( argv[ argnum ] );
         }; // end for all arguments
         if ( specialArgsFound ) return 0; // Everythings's OK, go home
 
-        if ( argc < 2) { // somethings's wrong, go home
+        int fileArgc = int( fileArgs.size() );
+        if ( fileArgc < 2) { // somethings's wrong, go home
             printUsage(argv[ 0 ]);
             return ( -1 );
         };
 
-        SetUpHardware( argc );
+        SetUpHardware( fileArgc, memorySize );
+        theCPU->engine = engine;
+        theCPU->aotJobs = &aotJobs;
+        if ( printStats )
+            std::atexit( printStatistics );
 
        
         
-        if(rmminixOS::boot(argc,argv)){
+        if(rmminixOS::boot(fileArgc,fileArgs.data(),schedulingPolicy,outputWriter,
+                           readAheadPolicy,writeCombiningPolicy)){
         //onley run the sim if booting when smooth 
            
         // Run The Simulation
         const int forever = 1024 * 1024; // infinite loop protection...
         for ( rmmixHardware::clock = 0;
               rmmixHardware::clock < forever;
-              rmmixHardware::clock++ )
-            for ( auto component : hardwareComponents ){ // C++11 for all loop!
-		
-                component.second->run( );
-		
-		
-		}
+              rmmixHardware::clock++ ) {
+            // While the CPU is idle, only the devices' count downs matter
+            if ( skipIdle && theCPU->idleTicks() )
+                if ( skipIdleTicks( forever - rmmixHardware::clock )
+                     && ( forever <= rmmixHardware::clock ) )
+                    break;
+            hardwareComponents.run( );
+        }; // end for all clock ticks
 	
         
         }
@@ -42,13 +42,24 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <cstdio> // for std::remove
+#include <chrono> // for the benchmark
+#include <iterator> // for std::istreambuf_iterator
 
 #include <vector> // needed for utility function acceptInput
 
 #include "UnitTesting.h"
 
 #include "RMMIXJobLang.h"
+#include "RMMIXbinaryObject.h"
+#include "RMMIXlexer.h"
 #include "RMMIXinstruction.h"
+#include "rmmixThreadedCode.h"
+#include "rmmixMemory.h"
+#include "rmmixAOT.h"
+#include "rmminixos.h"
+#include "rmminixScheduler.h"
+#include "rmminixOutput.h"
 
 /*****
  * Utility Fuction parseObjFile
@@ -161,8 +172,104 @@ void acceptInstructions( JobLangCompiler* compiler,
 
 } // end acceptInstructions
 
+/*****
+ * Utility Fuction readAllJobs
+ * Reads every job (code and input) in an object file, and - if record is
+ * true - returns everything it read as text, so that two readers can be
+ * compared.  Returns the number of lines read in lines.
+ ****/
+std::string readAllJobs( objectCodeDecompiler* decompiler, bool record,
+                         long long& lines ) {
+    std::stringstream transcript;
+    RMMIXinstruction instruction;
+    int number;
+    try {
+        while ( decompiler->gotoState( JobLangCompiler::codeReaderState ) ) {
+            if ( record ) transcript << "$JOB " << decompiler->jobname << '\n';
+            while ( *decompiler >> instruction )
+                if ( record ) transcript << instruction.dump() << '\n';
+            if ( ! decompiler->gotoState( JobLangCompiler::inputReaderState ) )
+                break;
+            while ( *decompiler >> number )
+                if ( record ) transcript << number << '\n';
+        }; // end while there are jobs
+    } catch ( std::string error ) {
+        transcript << error;
+    };
+    transcript << "eof " << decompiler->eof() << ", good " << decompiler->good()
+               << ", line " << decompiler->lineNumber << '\n';
+    lines = decompiler->lineNumber;
+    delete decompiler ; // !!!
+    return transcript.str();
+} // end readAllJobs
+
+/*****
+ * Utility Fuction lexNumbers
+ * Tests if the lexer reads the numbers in a line as a stream does
+ ****/
+void lexNumbers( const std::string& line ) {
+
+    std::cout << "Numbers in <" << line << ">" << std::endl;
+    for ( int base : { 10, 16 } ) {
+        RMMIX_JDL::lineLexer lexer;
+        lexer.scan( line.data(), line.data() + line.size() );
+        std::stringstream stream( lexer.text() );
+        stream >> ( ( 16 == base ) ? std::hex : std::dec );
+        std::stringstream expected, found;
+        int number;
+        while ( stream >> number ) expected << number << ' ';
+        while ( lexer.nextNumber( number, base ) ) found << number << ' ';
+        EQUALITY_TEST( expected.str(), found.str(), 
+                       "Lexer reads the same numbers as a stream" );
+    }; // end for both bases
+} // end lexNumbers
+
+/*****
+ * Utility Fuction compareReaders
+ * Tests if the scanning reader reads the same as the line reader
+ ****/
+void compareReaders( const char* fileName ) {
+
+    std::cout << std::endl << "TEST scanning reader on file " << fileName
+                                                               << std::endl;
+    long long lines = 0;
+    auto scanner = new objectCodeDecompiler( fileName );
+    ASSERTION_TEST( bool( scanner->text ), "File is scanned" );
+    EQUALITY_TEST( readAllJobs( new objectCodeDecompiler( fileName,
+                                    objectCodeDecompiler::lineReader ),
+                                true, lines ),
+                   readAllJobs( scanner, true, lines ),
+                   "Scanner reads the same as the line reader" );
+
+} // end compareReaders
+
+/*****
+ * Utility Fuction benchmarkReaders
+ * Times both readers on a (large) object file: unitTester --bench FILE
+ ****/
+void benchmarkReaders( const char* fileName ) {
+    for ( auto reader : { objectCodeDecompiler::lineReader,
+                          objectCodeDecompiler::scanningReader } ) {
+        long long lines = 0;
+        auto start = std::chrono::steady_clock::now();
+        readAllJobs( new objectCodeDecompiler( fileName, reader ), false, lines );
+        std::chrono::duration< double > seconds =
+            std::chrono::steady_clock::now() - start;
+        std::cout << ( ( objectCodeDecompiler::lineReader == reader )
+                       ? "line reader:     " : "scanning reader: " )
+                  << lines << " lines in " << seconds.count() << " s, "
+                  << (long long)( lines / seconds.count() ) << " lines per second"
+                  << std::endl;
+    }; // end for both readers
+} // end benchmarkReaders
+
 int main(int argc, char** argv)
 {
+    if ( ( 3 == argc ) && ( std::string( "--bench" ) == argv[ 1 ] ) ) {
+        benchmarkReaders( argv[ 2 ] );
+        return 0;
+    };
+
     std::cout << std::endl << "TEST TestRMMIX_JDL: OpCodes" << std::endl;
 
     EQUALITY_TEST( 0, int(RMMIX_JDL::NOP), "NOP should be numerically should be zero ");
@@ -204,6 +311,11 @@ int main(int argc, char** argv)
                RMMIX_JDL::lookup( RMMIX_JDL::trapCodes, RMMIX_JDL::PUTW ),
                "PUTW trap code should be symbolically PUTW " );
 
+    EQUALITY_TEST( std::string("getb"),
+               RMMIX_JDL::lookup( RMMIX_JDL::trapCodes, RMMIX_JDL::GETB ),
+               "GETB trap code should be symbolically getb " );
+    ASSERTION_TEST(RMMIX_JDL::trapCodeOK(RMMIX_JDL::BLOCK_READY), "BLOCK_READY is an OK trap code" );
+
     EQUALITY_TEST(65, int(RMMIX_JDL::FATAL), "FATAL should be numerically should be 65 " );
     EQUALITY_TEST( std::string("FATAL"),
                RMMIX_JDL::lookup( RMMIX_JDL::trapCodes, RMMIX_JDL::FATAL ),
@@ -222,6 +334,73 @@ int main(int argc, char** argv)
     EQUALITY_TEST( -1, RMMIX_JDL::lookup(RMMIX_JDL::opCodes, "FOO BAR"),
                 "lookup( FOO BAR ) -> -1" );
 
+    // TestCase TestRMMIX_JDL; test codeTables (must agree with the SymbolTables)
+    std::cout << std::endl << "TEST TestRMMIX_JDL, codeTables" << std::endl;
+
+    {
+        bool namesOK = true, codesOK = true;
+        for ( int code = -1; code <= RMMIX_JDL::maxTrapCode; ++code ) {
+            namesOK = namesOK
+                && ( RMMIX_JDL::lookup( RMMIX_JDL::opCodes, code )
+                     == RMMIX_JDL::opCodeName( code ) )
+                && ( RMMIX_JDL::lookup( RMMIX_JDL::trapCodes, code )
+                     == RMMIX_JDL::trapCodeName( code ) );
+        };
+        for ( const auto& symbol : RMMIX_JDL::opCodes )
+            codesOK = codesOK && ( symbol.second == RMMIX_JDL::lookupOpCode(
+                                       symbol.first.data(), symbol.first.size() ) );
+        for ( const auto& symbol : RMMIX_JDL::pseudoOpCodes )
+            codesOK = codesOK && ( symbol.second == RMMIX_JDL::lookupOpCode(
+                                       symbol.first.data(), symbol.first.size() ) );
+        for ( const auto& symbol : RMMIX_JDL::trapCodes )
+            codesOK = codesOK && ( symbol.second == RMMIX_JDL::lookupTrapCode(
+                                       symbol.first.data(), symbol.first.size() ) );
+        ASSERTION_TEST( namesOK, "opCodeName and trapCodeName agree with lookup" );
+        ASSERTION_TEST( codesOK, "lookupOpCode and lookupTrapCode agree with lookup" );
+    }
+    EQUALITY_TEST( 2, RMMIX_JDL::numberOfOperands( RMMIX_JDL::TRAP ), "TRAP has 2 operands" );
+    EQUALITY_TEST( 3, RMMIX_JDL::numberOfOperands( RMMIX_JDL::DIVI ), "DIVI has 3 operands" );
+    EQUALITY_TEST( int(RMMIX_JDL::ADDI), RMMIX_JDL::lookupOpCode( "ADDI,3", 4 ),
+                   "lookupOpCode( ADDI ) -> 4, without a terminating 0" );
+    EQUALITY_TEST( int(RMMIX_JDL::ADD), RMMIX_JDL::lookupOpCode( "ADDI", 3 ),
+                   "lookupOpCode( ADD ) -> 3, not ADDI" );
+    EQUALITY_TEST( -1, RMMIX_JDL::lookupOpCode( "add", 3 ), "lookupOpCode( add ) -> -1" );
+    EQUALITY_TEST( -1, RMMIX_JDL::lookupOpCode( "", 0 ), "lookupOpCode( ) -> -1" );
+    EQUALITY_TEST( -1, RMMIX_JDL::lookupTrapCode( "HALT", 4 ), "lookupTrapCode( HALT ) -> -1" );
+    EQUALITY_TEST( int(RMMIX_JDL::REAP), RMMIX_JDL::lookupTrapCode( "reap", 4 ),
+                   "lookupTrapCode( reap ) -> 8" );
+
+    // TestCase TestRMMIX_JDL; test lexer
+    std::cout << std::endl << "TEST TestRMMIX_JDL, lexer" << std::endl;
+
+    {
+        const std::string line = " \t,loop  ADDI,3 , -0x1F\t% comment, $RUN ";
+        RMMIX_JDL::lineLexer lexer;
+        ASSERTION_TEST( lexer.scan( line.data(), line.data() + line.size() ),
+                        "Line is not blank" );
+        EQUALITY_TEST( std::string( " loop  ADDI 3   -0x1F" ), lexer.text(),
+                       "Cleaned up: no comment, commas are spaces" );
+        ASSERTION_TEST( ! lexer.isKeyword( "$RUN" ), "Not a $RUN line" );
+        RMMIX_JDL::textView token;
+        std::string tokens;
+        while ( lexer.nextToken( token ) ) tokens += token.str() + '|';
+        EQUALITY_TEST( std::string( "loop|ADDI|3|-0x1F|" ), tokens,
+                       "Tokens, separated by white space or commas" );
+        const std::string blank = " \t, % just a comment";
+        ASSERTION_TEST( ! lexer.scan( blank.data(), blank.data() + blank.size() ),
+                        "Line is blank" );
+        const std::string run = "  $RUN,% input";
+        lexer.scan( run.data(), run.data() + run.size() );
+        ASSERTION_TEST( lexer.isKeyword( "$RUN" ), "A $RUN line" );
+        ASSERTION_TEST( ! lexer.isKeyword( "$RU" ), "Not a $RU line" );
+    }
+    for ( const char* line : { "1 2 3", "-1,+2 ,0", "0x1f 0X1F -0x 0x", 
+                               "12abc 3", "12g 3", "00012 -0 +-1", 
+                               "2147483647 -2147483648", "2147483648 1",
+                               "7fffffff -80000000 80000000", "ffffffff",
+                               "- 5", "99999999999999999999 1", ".5 5." } )
+        lexNumbers( line );
+
     // Test TestRMMIXInstruction; test Basis
     std::cout << std::endl << "TEST TestRMMIXInstruction, Basis" << std::endl;
 
@@ -240,6 +419,372 @@ int main(int argc, char** argv)
      std::string( "Instruction:  op = MOV, 4 fields [0]=1 [1]=30 [2]=40 [3]=50"),
                               "instruction 1, 3, 30, 40, 50 constructed OK"   );
 
+    // Test TestRMMIXInstruction; test Packing (for the simulator)
+    std::cout << std::endl << "TEST TestRMMIXInstruction, Packing" << std::endl;
+
+    {
+        std::vector< RMMIXinstruction > unpacked{
+            RMMIXinstruction( RMMIX_JDL::NOP,   0 ),
+            RMMIXinstruction( RMMIX_JDL::ADD,   3, 31, 0, 255 ),
+            RMMIXinstruction( RMMIX_JDL::ADDI,  3, 1, 2, -2147483647 - 1 ),
+            RMMIXinstruction( RMMIX_JDL::JMPI,  1, -4 ),
+            RMMIXinstruction( RMMIX_JDL::MOV,   2, 256, 1 ),    // does not fit
+            RMMIXinstruction( RMMIX_JDL::STWI,  2, -1, 1000 ),  // does not fit
+            RMMIXinstruction( RMMIX_JDL::TRAP,  2, RMMIX_JDL::FATAL, 123456 ),
+            RMMIXinstruction( RMMIX_JDL::BNEGI, 2, 7, 2 ) };
+        packedProgram packed( unpacked );
+        bool same = ( unpacked.size() == packed.size() );
+        for ( std::size_t i = 0; same && ( i < unpacked.size() ); ++i )
+            same = ( unpacked[ i ].dump() == packed[ i ].dump() );
+        ASSERTION_TEST( same, "packed programs unpack to the same instructions" );
+        packedInstruction instruction;
+        ASSERTION_TEST( instruction.pack( unpacked[ 2 ] ),
+                        "ADDI with an immediate operand fits" );
+        EQUALITY_TEST( -2147483647 - 1, instruction.immediate,
+                       "the immediate operand is kept as is" );
+        ASSERTION_TEST( ! instruction.pack( unpacked[ 4 ] ),
+                        "register 256 does not fit" );
+        ASSERTION_TEST( ! instruction.pack( RMMIXinstruction() ),
+                        "a blank instruction does not fit" );
+        packed.clear();
+        EQUALITY_TEST( std::size_t( 0 ), packed.size(), "cleared program is empty" );
+    }
+
+    // Test TestRMMIXInstruction; test Decoding (for the threadedEngine)
+    std::cout << std::endl << "TEST TestRMMIXInstruction, Decoding" << std::endl;
+
+    std::vector< RMMIXinstruction > program{
+        RMMIXinstruction( RMMIX_JDL::MOVI, 2, 30, 0 ),
+        RMMIXinstruction( RMMIX_JDL::TRAP, 2, RMMIX_JDL::HALT, 30 ) };
+    decodedProgram decoded;
+    decoded.decode( packedProgram( program ) );
+    EQUALITY_TEST( 2, decoded.size(), "one decoded instruction per instruction" );
+    ASSERTION_TEST( decodedProgram::handlerFor( RMMIX_JDL::TRAP )
+                                         == decoded.code[1].handler,
+                    "TRAP decoded to the TRAP handler" );
+    EQUALITY_TEST( int( RMMIX_JDL::HALT ), decoded.code[1].a,
+                   "decoded TRAP keeps its trap code" );
+    EQUALITY_TEST( program[0].dump(), decoded.listing[0],
+                   "decoded program keeps the text for the log file" );
+    ASSERTION_TEST( decodedProgram::handlerFor( RMMIX_JDL::NOP )
+                                         != decodedProgram::handlerFor( -1 ),
+                    "illegal op codes do not get a legal handler" );
+
+    // Test TestRMMIXInstruction; test fusion into superinstructions
+    std::cout << std::endl << "TEST TestRMMIXInstruction, Fusion" << std::endl;
+
+    std::vector< RMMIXinstruction > pairs{
+        RMMIXinstruction( RMMIX_JDL::SUB,   3, 13, 10, 11 ),
+        RMMIXinstruction( RMMIX_JDL::BEQZI, 2, 13, 2 ),
+        RMMIXinstruction( RMMIX_JDL::ADDI,  3, 11, 11, 1 ),
+        RMMIXinstruction( RMMIX_JDL::JMPI,  1, -4 ),
+        RMMIXinstruction( RMMIX_JDL::MOVI,  2, 0, 5 ),
+        RMMIXinstruction( RMMIX_JDL::TRAP,  2, RMMIX_JDL::HALT, 30 ) };
+    decodedProgram fusedProgram;
+    fusedProgram.decode( packedProgram( pairs ) );
+    ASSERTION_TEST( nullptr != fusedProgram.code[0].fusedHandler,
+                    "SUB then BEQZI is fused" );
+    ASSERTION_TEST( nullptr == fusedProgram.code[1].fusedHandler,
+                    "the second instruction of a pair is not fused" );
+    ASSERTION_TEST( nullptr != fusedProgram.code[2].fusedHandler,
+                    "ADDI then JMPI is fused" );
+    ASSERTION_TEST( nullptr == fusedProgram.code[4].fusedHandler,
+                    "instructions writing to the program counter are not fused" );
+    EQUALITY_TEST( 2, fusedProgram.numberFused(), "two superinstructions" );
+
+    // Test TestRMMIXInstruction; test JIT (native code for hot blocks)
+    std::cout << std::endl << "TEST TestRMMIXInstruction, JIT" << std::endl;
+
+    std::vector< RMMIXinstruction > loop{
+        RMMIXinstruction( RMMIX_JDL::ADDI,  3, 1, 1, 1 ),
+        RMMIXinstruction( RMMIX_JDL::MUL,   3, 2, 1, 1 ),
+        RMMIXinstruction( RMMIX_JDL::BNEZI, 2, 3, -3 ) };
+    decodedProgram hotProgram;
+    hotProgram.decode( packedProgram( loop ) );
+    const jitBlock* block = nullptr;
+    for ( int i = 1; i < jitBlockCache::hotThreshold; ++i )
+        block = hotProgram.jit.reach( hotProgram, 0, 1024 );
+    ASSERTION_TEST( nullptr == block, "cold blocks are not compiled" );
+#if defined(__x86_64__)
+    block = hotProgram.jit.reach( hotProgram, 0, 1024 );
+    ASSERTION_TEST( nullptr != block, "hot blocks are compiled" );
+    if ( block ) {
+        EQUALITY_TEST( 3, block->length, "block ends with the branch" );
+        int registers[ 32 ] = { 0 };
+        registers[ 1 ] = 4;
+        registers[ 3 ] = 1;
+        EQUALITY_TEST( 3, block->nativeCode( registers, nullptr ),
+                       "native code runs the whole block" );
+        EQUALITY_TEST( 25, registers[ 2 ], "native code computes r2 = r1 * r1" );
+        EQUALITY_TEST( 0, registers[ 0 ], "native code takes the branch" );
+    };
+    std::ifstream maps( "/proc/self/maps" ); // (Linux only)
+    bool writableCode = false;
+    for ( std::string mapping; std::getline( maps, mapping ); )
+        writableCode = writableCode || ( std::string::npos != mapping.find( " rwx" ) );
+    ASSERTION_TEST( ! writableCode, "no memory is writable and executable at once" );
+#endif
+
+    // Test TestRMMIXInstruction; test AOT (jobs compiled by rmmixaot)
+    std::cout << std::endl << "TEST TestRMMIXInstruction, AOT" << std::endl;
+
+    std::vector< RMMIXinstruction > otherLoop( loop );
+    otherLoop[ 0 ].fields[ 3 ] = 2; // ADDI 1 1 2
+    ASSERTION_TEST( aotFingerprint( loop ) == aotFingerprint( loop ),
+                    "fingerprints are reproducible" );
+    ASSERTION_TEST( aotFingerprint( loop ) != aotFingerprint( otherLoop ),
+                    "different programs get different fingerprints" );
+    ASSERTION_TEST( aotFingerprint( loop ) == aotFingerprint( packedProgram( loop ) ),
+                    "packing a program does not change its fingerprint" );
+    aotTranslator translator;
+    translator.addJob( "loop", loop );
+    std::ostringstream aotSource;
+    translator.write( aotSource );
+    ASSERTION_TEST( std::string::npos != aotSource.str().find( "goto L0;" ),
+                    "jumps within the job become gotos" );
+    ASSERTION_TEST( std::string::npos != aotSource.str().find( "rmmix_aot_jobs" ),
+                    "the library has a table of jobs" );
+    aotLibrary noLibrary;
+    ASSERTION_TEST( ! noLibrary.open( "noSuchLibrary.so" ),
+                    "missing libraries cannot be opened" );
+
+    // Test rmminixOS; test the job queues (intrusive, FIFO)
+    std::cout << std::endl << "TEST rmminixOS, jobQueue" << std::endl;
+
+    std::vector< rmminixOS::processControlBlock > jobs( 4 );
+    rmminixOS::jobQueue queue( jobs );
+    ASSERTION_TEST( queue.empty(), "new queues are empty" );
+    EQUALITY_TEST( rmminixOS::noJob, queue.pop(), "empty queues pop no job" );
+    for ( int job = 0; job < 4; ++job )
+        queue.push( job );
+    EQUALITY_TEST( 4, queue.size(), "four jobs queued" );
+    queue.remove( 2 ); // from the middle
+    queue.remove( 3 ); // from the end
+    queue.push( 2 );
+    EQUALITY_TEST( 0, queue.pop(), "first in, first out" );
+    EQUALITY_TEST( 1, queue.pop(), "removed jobs are skipped" );
+    EQUALITY_TEST( 2, queue.front(), "pushed jobs go to the end" );
+    EQUALITY_TEST( 2, queue.pop(), "the last job" );
+    ASSERTION_TEST( queue.empty(), "queue is empty again" );
+
+    // Test rmminixOS; test the scheduling policies
+    std::cout << std::endl << "TEST rmminixOS, schedulingPolicy" << std::endl;
+
+    rmminixOS::schedulingPolicy* policy =
+        rmminixOS::makeSchedulingPolicy( "", jobs );
+    ASSERTION_TEST( ! policy->usesTimer(), "by default, there are no time slices" );
+    delete policy;
+    policy = rmminixOS::makeSchedulingPolicy( "rr:7", jobs );
+    EQUALITY_TEST( 7, policy->quantum( 0 ), "round robin with a quantum of 7" );
+    delete policy;
+    policy = rmminixOS::makeSchedulingPolicy( "priority", jobs );
+    policy->add( 3 );
+    policy->add( 1 );
+    EQUALITY_TEST( 1, policy->next(), "the job named first goes first" );
+    ASSERTION_TEST( policy->preempts( 1, 3 ), "and preempts the others" );
+    delete policy;
+    policy = rmminixOS::makeSchedulingPolicy( "mlfq:4", jobs );
+    EQUALITY_TEST( 4, policy->quantum( 2 ), "top level quantum" );
+    policy->expired( 2 );
+    EQUALITY_TEST( 8, policy->quantum( 2 ), "one level down, twice as long" );
+    policy->add( 2 );
+    policy->add( 0 );
+    EQUALITY_TEST( 0, policy->next(), "higher levels go first" );
+    delete policy;
+    bool unknownPolicy = false;
+    try {
+        rmminixOS::makeSchedulingPolicy( "lottery", jobs );
+    } catch ( std::string error ) {
+        unknownPolicy = true;
+    };
+    ASSERTION_TEST( unknownPolicy, "unknown policies are rejected" );
+
+    // Test rmminixOS; test the read-ahead policies
+    std::cout << std::endl << "TEST rmminixOS, readAheadPolicy" << std::endl;
+
+    EQUALITY_TEST( 0, rmminixOS::makeReadAheadPolicy( "" ).depth,
+                   "by default, there is no read-ahead" );
+    EQUALITY_TEST( 8, rmminixOS::makeReadAheadPolicy( "16" ).burst,
+                   "bursts of half the depth" );
+    EQUALITY_TEST( 3, rmminixOS::makeReadAheadPolicy( "12:3" ).burst,
+                   "or as given" );
+    bool badReadAhead = false;
+    try {
+        rmminixOS::makeReadAheadPolicy( "4:8" );
+    } catch ( std::string error ) {
+        badReadAhead = true;
+    };
+    ASSERTION_TEST( badReadAhead, "bursts larger than the buffer are rejected" );
+    EQUALITY_TEST( 16, rmminixOS::makeWriteCombiningPolicy( "8" ).limit,
+                   "write-combining: room for two blocks" );
+    bool badCombining = false;
+    try {
+        rmminixOS::makeWriteCombiningPolicy( "8:4" );
+    } catch ( std::string error ) {
+        badCombining = true;
+    };
+    ASSERTION_TEST( badCombining, "a limit below the block size is rejected" );
+
+    // Test the interrupt controller
+    std::cout << std::endl << "TEST rmmixHardware, rmmixInterruptController" << std::endl;
+
+    rmmixCPU cpu( 0 );
+    rmmixInterruptController interrupts;
+    interrupts.raise( 4, RMMIX_JDL::PUTW_READY, 4, 0 );
+    interrupts.raise( 1, RMMIX_JDL::GETW_READY, 1, 0 );
+    interrupts.raise( 1, RMMIX_JDL::GETW_READY, 1, 1 );
+    interrupts.mask( 1 );
+    interrupts.deliver( cpu );
+    EQUALITY_TEST( 4, cpu.trapData, "masked devices must wait" );
+    interrupts.deliver( cpu );
+    EQUALITY_TEST( 2, interrupts.pending(), "one interrupt at a time" );
+    cpu.trapNumber = 0;
+    interrupts.unmask( 1 );
+    interrupts.deliver( cpu );
+    ASSERTION_TEST( ( 1 == cpu.trapData ) && ( 0 == cpu.trapStatus ),
+                    "lowest device number first, in the order raised" );
+    cpu.trapNumber = 0;
+    interrupts.withdraw( 1 );
+    interrupts.deliver( cpu );
+    ASSERTION_TEST( ( 0 == cpu.trapNumber ) && ( 0 == interrupts.pending() ),
+                    "withdrawn interrupts are not delivered" );
+    EQUALITY_TEST( 2LL, interrupts.delivered, "two interrupts delivered" );
+
+    // Test the data memory (and how LDW and STW use it)
+    std::cout << std::endl << "TEST rmmixHardware, sparseMemory" << std::endl;
+
+    EQUALITY_TEST( 1024, cpu.dataMemorySize, "1024 words of data memory by default" );
+    EQUALITY_TEST( 3000, sparseMemory::parseSize( "3000" ), "memory size in words" );
+    EQUALITY_TEST( 64 * 1024 * 1024, sparseMemory::parseSize( "64M" ),
+                   "memory size in megawords" );
+    int badSizes = 0;
+    for ( const char* spec : { "", "0", "2G", "99999999999", "1g", "4KB", "-1" } ) {
+        try {
+            sparseMemory::parseSize( spec );
+        } catch ( std::string error ) {
+            ++badSizes;
+        };
+    };
+    EQUALITY_TEST( 7, badSizes, "bad memory sizes are rejected" );
+    {
+        sparseMemory memory( sparseMemory::parseSize( "1G" ) );
+        memory[ memory.size() - 1 ] = 42;
+        ASSERTION_TEST( ( 0 == memory[ 0 ] ) && ( 0 == memory[ memory.size() / 2 ] )
+                        && ( 42 == memory[ memory.size() - 1 ] ),
+                        "a gigaword of memory, all zero until written" );
+        ASSERTION_TEST( memory.residentBytes() < 1024 * 1024,
+                        "untouched memory is not resident" );
+    }
+    cpu.trapNumber = cpu.trapData = 0;
+    cpu.registers[ 0 ] = 0;
+    cpu.registers[ 1 ] = cpu.dataMemorySize;
+    RMMIXinstruction store( RMMIX_JDL::STW, 2, 2, 1 );
+    cpu.executeInstruction( store );
+    ASSERTION_TEST( ( RMMIX_JDL::FATAL == cpu.trapNumber ) && ( 1 == cpu.registers[ 0 ] ),
+                    "STW outside the data memory raises FATAL" );
+    cpu.trapNumber = 0;
+    cpu.idle();
+
+    // Test the verifier and the checked path
+    std::cout << std::endl << "TEST rmmixHardware, Verifier" << std::endl;
+
+    packedProgram unsafe( std::vector< RMMIXinstruction >{
+        RMMIXinstruction( RMMIX_JDL::MOVI, 2, 1, 0 ),
+        RMMIXinstruction( RMMIX_JDL::BEQZI, 2, 1, 10 ),    // branches out
+        RMMIXinstruction( RMMIX_JDL::MOV, 2, 40, 1 ),      // no register 40
+        RMMIXinstruction( RMMIX_JDL::TRAP, 2, RMMIX_JDL::HALT, 99 ),
+        RMMIXinstruction( RMMIX_JDL::TRAP, 2, RMMIX_JDL::PUTB, 99 ), // OS checks
+        RMMIXinstruction( RMMIX_JDL::STWI, 2, 1, cpu.dataMemorySize ),
+        RMMIXinstruction( RMMIX_JDL::JMPI, 1, -7 ) } );
+    unsafe.unverified = cpu.verify( unsafe );
+    ASSERTION_TEST( ( std::vector< int >{ 1, 2, 3, 5 } == unsafe.unverified )
+                    && ! unsafe.verified(),
+                    "verifier finds the unsafe instructions" );
+    ASSERTION_TEST( cpu.verify( RMMIX_JDL::STWI, 1, cpu.dataMemorySize - 1, 0, 0, 1 )
+                    && ! cpu.verify( RMMIX_JDL::LDWI, 1, -1, 0, 0, 1 )
+                    && ! cpu.verify( RMMIX_JDL::JMPI, 0, 0, 0, 0, 1 ),
+                    "verifier checks addresses and branch targets" );
+    decodedProgram checked;
+    checked.decode( unsafe );
+    ASSERTION_TEST( decodedProgram::isChecked( checked.code[ 2 ] )
+                    && ! decodedProgram::isChecked( checked.code[ 4 ] ),
+                    "unsafe instructions are decoded to the checked path" );
+    cpu.instructionMemory = &unsafe;
+    cpu.registers[ 0 ] = 1;
+    cpu.registers[ 1 ] = 1;
+    RMMIXinstruction branch = unsafe[ 1 ];
+    cpu.executeChecked( branch );
+    ASSERTION_TEST( ( 0 == cpu.trapNumber ) && ( 2 == cpu.registers[ 0 ] ),
+                    "a branch out of the program is harmless, if not taken" );
+    RMMIXinstruction move = unsafe[ 2 ];
+    cpu.executeChecked( move );
+    ASSERTION_TEST( ( RMMIX_JDL::FATAL == cpu.trapNumber ) && ( 3 == cpu.registers[ 0 ] ),
+                    "an unsafe instruction raises FATAL on the checked path" );
+    cpu.trapNumber = 0;
+    cpu.instructionMemory = nullptr;
+    cpu.idle();
+
+    // Test that superinstructions do what the instructions do one by one
+    std::cout << std::endl << "TEST rmmixHardware, engineParity" << std::endl;
+
+    std::vector< RMMIXinstruction > pcProgram{
+        RMMIXinstruction( RMMIX_JDL::SUB,   3, 1, 2, 3 ),
+        RMMIXinstruction( RMMIX_JDL::BEQZI, 2, 0, 2 ) }; // tests the program counter
+    decodedProgram pcDecoded;
+    pcDecoded.decode( packedProgram( pcProgram ) );
+    ASSERTION_TEST( nullptr == pcDecoded.code[0].fusedHandler,
+                    "BEQZI testing the program counter is not fused" );
+    cpu.registers[ 0 ] = 0;
+    for ( RMMIXinstruction instruction : pcProgram )
+        cpu.executeInstruction( instruction );
+    const int switchPC = cpu.registers[ 0 ];
+    cpu.registers[ 0 ] = 0;
+    const decodedInstruction& first = pcDecoded.code[0];
+    if ( first.fusedHandler )
+        first.fusedHandler( cpu, first );
+    else {
+        first.handler( cpu, first );
+        pcDecoded.code[1].handler( cpu, pcDecoded.code[1] );
+    };
+    ASSERTION_TEST( ( 2 == switchPC ) && ( switchPC == cpu.registers[ 0 ] ),
+                    "threaded code branches just like the switch engine" );
+    cpu.idle();
+
+    // Test rmminixOS; test the output channels (with both writers)
+    std::cout << std::endl << "TEST rmminixOS, outputChannel" << std::endl;
+
+    for ( auto writer : { rmminixOS::outputChannel::bufferedWriter,
+                          rmminixOS::outputChannel::mappedWriter } ) {
+        rmminixOS::outputChannel channel( writer );
+        ASSERTION_TEST( channel.good() && ! channel.is_open(),
+                        "new channels are closed, but good" );
+        channel.open( "unitTesterOutput.txt" );
+        ASSERTION_TEST( channel.is_open(), "channel opened" );
+        for ( int word = 0; word < 300000; ++word ) // more than fits in memory at once
+            channel << word << '\n';
+        ASSERTION_TEST( channel.close(), "channel written and closed" );
+        std::ifstream written( "unitTesterOutput.txt" );
+        int word = -1, words = 0, lastWord = -1;
+        while ( written >> word ) {
+            ++words;
+            lastWord = word;
+        };
+        EQUALITY_TEST( 300000, words, "every word is in the file" );
+        EQUALITY_TEST( 299999, lastWord, "and nothing after the last one" );
+        channel.open( "unitTesterOutput.txt" );
+        channel << 42 << '\n';
+        channel.close();
+        std::ifstream rewritten( "unitTesterOutput.txt" );
+        rewritten >> word;
+        ASSERTION_TEST( ( 42 == word ) && ! ( rewritten >> word ),
+                        "opening a channel truncates its file" );
+        channel.open( "noSuchDirectory/unitTesterOutput.txt" );
+        ASSERTION_TEST( ! ( channel << 42 ), "cannot write where there is no file" );
+        ASSERTION_TEST( ! channel.close() && channel.good(),
+                        "closing reports the failure, and the channel is good again" );
+    };
+    std::remove( "unitTesterOutput.txt" );
+
     // EXPECT_ASSERTION_FAILURE(ins0.reset( -42,   0 ));
     // EXPECT_ASSERTION_FAILURE(ins0.reset(  42,   0 ));
     // EXPECT_ASSERTION_FAILURE(ins0.reset(   1, -42 ));
@@ -347,6 +892,118 @@ int main(int argc, char** argv)
                       "Instruction:  op = TRAP, 3 fields [0]=15 [1]=1 [2]=30"
                                                   } );
 
+    std::cout << std::endl << "TEST TestRMMIXJobLang, scanningReader " << std::endl;
+
+    // the scanner must read exactly what the line reader reads
+    for ( const char* refFile : { "tests/test0.ref", "tests/test0a.ref",
+                                  "tests/test0b.ref", "tests/test0c.ref",
+                                  "tests/test1.ref", "tests/test2a.ref",
+                                  "tests/test2b.ref", "tests/test3.ref",
+                                  "tests/test4.ref", "tests/testErrors.ref",
+                                  "tests/bigtest.ref" } )
+        compareReaders( refFile );
+    {
+        std::ofstream tricky( "unitTesterObject.obj", std::ios::binary );
+        tricky << "% comments, commas, blank lines, odd numbers\n\n"
+                  "  $JOB  tricky   % job name\n"
+                  "2, 1e, 0\r\n"
+                  ",f,2 , 1e ,\n"
+                  "   \t\n"
+                  "  5 a b c  %  sub\n"
+                  "$RUN,\n"
+                  "2a\n-0x1f % negative\n+10\n 12g \n7fffffff\n-80000000\n"
+                  "80000000\n"
+                  "$END\n"
+                  "$JOB bad\n"
+                  "2 1\n"
+                  "$RUN\n"
+                  "$END"; // no newline at the end
+    }
+    compareReaders( "unitTesterObject.obj" );
+    {
+        std::ofstream tricky( "unitTesterObject.obj", std::ios::binary );
+        tricky << "$JOB last\n2 1 0\n$RUN\n3\n$END\n$JOB"; // no job name
+    }
+    compareReaders( "unitTesterObject.obj" );
+    std::remove( "unitTesterObject.obj" );
+
+    std::cout << std::endl << "TEST TestRMMIXJobLang, binaryObject " << std::endl;
+
+    // write two jobs in the binary object format (as rmmixas --binary
+    // --symbols does), then read them back as the simulator does
+    RMMIX_JDL::binaryObjectWriter writer( true );
+    for ( const char* jobFile : { "tests/test2b.job", "tests/test3.job" } ) {
+        assemblyCompiler compiler( jobFile );
+        compiler.gotoState( JobLangCompiler::codeReaderState );
+        writer.addJob( compiler.jobname );
+        RMMIXinstruction instruction;
+        while ( compiler >> instruction )
+            writer.addInstruction( instruction );
+        writer.addSymbols( compiler.jumpTable );
+        compiler.gotoState( JobLangCompiler::inputReaderState );
+        writer.startInput( );
+        for ( int number; compiler >> number; )
+            writer.addInput( number );
+    };
+    {
+        std::ofstream binaryFile( "unitTesterObject.bin", std::ios::binary );
+        ASSERTION_TEST( writer.write( binaryFile ), "binary object written" );
+    }
+    objectCodeDecompiler binaryDecompiler( "unitTesterObject.bin" );
+    ASSERTION_TEST( binaryDecompiler.good() && binaryDecompiler.image,
+                    "binary object file mapped" );
+    objectCodeDecompiler textDecompiler( "tests/test2b.ref" );
+    ASSERTION_TEST( binaryDecompiler.gotoState( JobLangCompiler::codeReaderState )
+                    && textDecompiler.gotoState( JobLangCompiler::codeReaderState ),
+                    "both decompilers found $JOB" );
+    EQUALITY_TEST( textDecompiler.jobname, binaryDecompiler.jobname,
+                   "same job name" );
+    RMMIXinstruction binaryInstruction, textInstruction;
+    int instructions = 0;
+    while ( textDecompiler >> textInstruction ) {
+        ASSERTION_TEST( bool( binaryDecompiler >> binaryInstruction ),
+                        "binary instruction read" );
+        EQUALITY_TEST( textInstruction.dump(), binaryInstruction.dump(),
+                       "same instruction" );
+        ++instructions;
+    };
+    EQUALITY_TEST( 8, instructions, "all instructions compared" );
+    ASSERTION_TEST( ! ( binaryDecompiler >> binaryInstruction ),
+                    "no instructions after the last one" );
+    int binaryNumber = 0, textNumber = 0, numbers = 0;
+    while ( textDecompiler >> textNumber ) {
+        ASSERTION_TEST( bool( binaryDecompiler >> binaryNumber ),
+                        "binary input read" );
+        EQUALITY_TEST( textNumber, binaryNumber, "same input" );
+        ++numbers;
+    };
+    EQUALITY_TEST( 2, numbers, "all input compared" );
+    ASSERTION_TEST( ! ( binaryDecompiler >> binaryNumber ),
+                    "no input after the last number" );
+    EQUALITY_TEST( 1, binaryDecompiler.image->symbols( 0 ), "test2b has one label" );
+    EQUALITY_TEST( std::string( "out" ), std::string( binaryDecompiler.image->symbolName( 0, 0 ) ),
+                   "label name" );
+    EQUALITY_TEST( 5, binaryDecompiler.image->symbolValue( 0, 0 ), "label value" );
+    ASSERTION_TEST( binaryDecompiler.gotoState( JobLangCompiler::codeReaderState ),
+                    "next $JOB found" );
+    EQUALITY_TEST( std::string( "test3" ), binaryDecompiler.jobname, "next job name" );
+    ASSERTION_TEST( ( binaryDecompiler >> binaryInstruction )
+                    && binaryDecompiler.gotoState( JobLangCompiler::inputReaderState )
+                    && ( binaryDecompiler >> binaryNumber ) && ( 24 == binaryNumber ),
+                    "skip to the input of the next job" );
+    ASSERTION_TEST( ! binaryDecompiler.gotoState( JobLangCompiler::codeReaderState ),
+                    "no job after the last one" );
+    {   // a truncated file is rejected when it is opened
+        std::ifstream whole( "unitTesterObject.bin", std::ios::binary );
+        std::string contents( ( std::istreambuf_iterator< char >( whole ) ),
+                              std::istreambuf_iterator< char >() );
+        std::ofstream truncated( "unitTesterObject.bin", std::ios::binary );
+        truncated.write( contents.data(), 100 );
+    }
+    objectCodeDecompiler truncatedDecompiler( "unitTesterObject.bin" );
+    ASSERTION_TEST( ! truncatedDecompiler.good(), "truncated binary object file is bad" );
+    std::remove( "unitTesterObject.bin" );
+
     std::cout << std::endl
               << "\tFinished with all tests." << std::endl
               <<  ( testing::AllTestsSuccessful ? "\tAll tests passed!"